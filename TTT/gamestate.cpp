@@ -99,7 +99,7 @@ GameState::GameState(const GameState &pRH,const Move &pMove)
  * who is not making the move
 
  */
-void GameState::tryMove(std::vector<Move> &pMoves, int pCell) const
+void GameState::tryMove(MoveList &pMoves, int pCell) const
 {
     int lR=cellToRow(pCell);
     int lC=cellToCol(pCell);
@@ -156,21 +156,31 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
 {
     pStates.clear();
 
+    MoveList lMoves;
+    generateMoves(lMoves);
+
+    // Convert moves to GameStates
+    for (int i = 0; i < lMoves.size(); ++i)
+    	pStates.push_back(GameState(*this, lMoves[i]));
+}
+
+/**
+ * Returns the list of all valid moves in this state
+ *
+ * \param pMoves the list where the moves will be stored (it is cleared first)
+ */
+void GameState::generateMoves(MoveList &pMoves) const
+{
+    pMoves.clear();
+
     if (mLastMove.isEOG())
     	return;
 
-	std::vector<Move> lMoves;
-	
     for (int k = 0; k < cSquares; ++k)
     {
-        int lCell = k;       
-        tryMove(lMoves, lCell);		
-    }   
-	
-    // Convert moves to GameStates
-    for (unsigned i = 0; i < lMoves.size(); ++i)
-    	pStates.push_back(GameState(*this, lMoves[i]));	
-    
+        int lCell = k;
+        tryMove(pMoves, lCell);
+    }
 }
 
 /**
@@ -182,9 +192,10 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
  */
 void GameState::doMove(const Move &pMove)
 {
-   // set the piece
-		at(pMove[0]) = pMove[1];
-   
+    // set the piece (moves without cells, such as the null move, only pass the turn)
+    if (pMove.length() > 0)
+        at(pMove[0]) = pMove[1];
+
     // Remember last move
     mLastMove = pMove;
 
@@ -193,6 +204,23 @@ void GameState::doMove(const Move &pMove)
 
 }
 
+/**
+ * Takes back a move made with doMove(pMove, pUndo)
+ *
+ * \param pMove the move to take back
+ * \param pUndo the information stored by doMove
+ */
+void GameState::undoMove(const Move &pMove, const UndoInfo &pUndo)
+{
+    // remove the piece
+    if (pMove.length() > 0)
+        at(pMove[0]) = CELL_EMPTY;
+
+    // Restore last move and player
+    mLastMove = pUndo.mLastMove;
+    mNextPlayer = mNextPlayer ^ (CELL_X | CELL_O);
+}
+
 /**
  * Convert the board to a human readable string ready to be printed to std::cerr
  *
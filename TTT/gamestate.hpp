@@ -8,6 +8,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace TICTACTOE
 {
@@ -165,7 +166,7 @@ private:
 	 * \param pOther the \ref ECell code corresponding to the player
 	 * who is not making the move
 	 */
-	void tryMove(std::vector<Move> &pMoves, int pCell) const;
+	void tryMove(MoveList &pMoves, int pCell) const;
 	
 	
 private:
@@ -263,6 +264,24 @@ public:
 	 */
 	void findPossibleMoves(std::vector<GameState> &pMoves) const;
 
+	/**
+	 * Returns the list of all valid moves in this state
+	 *
+	 * The moves are the same, and in the same order, as the ones leading to
+	 * the states returned by findPossibleMoves, but no state is copied.
+	 *
+	 * \param pMoves the list where the moves will be stored (it is cleared first)
+	 */
+	void generateMoves(MoveList &pMoves) const;
+
+	/**
+	 * Information needed to take back a move performed with doMove
+	 */
+	struct UndoInfo
+	{
+		Move mLastMove;		///< the last move before the move was made
+	};
+
 	/**
 	 * Transforms the board by performing a move
 	 *
@@ -272,6 +291,27 @@ public:
 	 */
 	void doMove(const Move &pMove);
 
+	/**
+	 * Same as above, but also stores in \p pUndo what undoMove needs to restore the state
+	 *
+	 * \param pMove the move to perform
+	 * \param pUndo where the information to undo the move is stored
+	 */
+	void doMove(const Move &pMove, UndoInfo &pUndo)
+	{
+		pUndo.mLastMove = mLastMove;
+		doMove(pMove);
+	}
+
+	/**
+	 * Takes back a move made with doMove(pMove, pUndo)
+	 *
+	 * Moves must be undone in the reverse order they were made.
+	 * \param pMove the move to take back
+	 * \param pUndo the information stored by doMove
+	 */
+	void undoMove(const Move &pMove, const UndoInfo &pUndo);
+
 	/**
 	 * Compares two game states. Return true if game states are identical, otherwise false.
 	 *
@@ -1,4 +1,5 @@
 #include "player.hpp"
+#include "minimax.h"
 
 #include <stdlib.h>
 #include <iostream>
@@ -10,6 +11,11 @@ int main(int argc, char **argv)
     bool init = false;
     bool verbose = false;
     bool fast = false;
+    bool ponder = false;
+    int threads = 1;
+    std::string clock_name;
+    std::string database_path;
+    std::string solve_path;
     for (int i = 1; i < argc; ++i)
     {
         std::string param(argv[i]);
@@ -19,6 +25,16 @@ int main(int argc, char **argv)
             verbose = true;
         else if (param == "fast" || param == "f")
             fast = true;
+        else if (param == "ponder" || param == "p")
+            ponder = true;
+        else if ((param == "threads" || param == "t") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if ((param == "clock" || param == "c") && i + 1 < argc && (std::string(argv[i + 1]) == "cpu" || std::string(argv[i + 1]) == "wall"))
+            clock_name = argv[++i];
+        else if ((param == "database" || param == "d") && i + 1 < argc)
+            database_path = argv[++i];
+        else if (param == "solve" && i + 1 < argc)
+            solve_path = argv[++i];
         else
         {
             std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
@@ -26,6 +42,29 @@ int main(int argc, char **argv)
         }
     }
 
+    // Solve the game, write the database and quit if the parameter "solve" is given
+    if (!solve_path.empty())
+    {
+        if (TICTACTOE::OutcomeDatabase::generate(solve_path))
+            return 0;
+        std::cerr << "Cannot write the database to '" << solve_path << "'" << std::endl;
+        return -1;
+    }
+
+    TICTACTOE::OutcomeDatabase database;
+    if (!database_path.empty() && !database.open(database_path))
+    {
+        std::cerr << "Cannot open the database '" << database_path << "'" << std::endl;
+        return -1;
+    }
+
+    TICTACTOE::MiniMax::set_threads(threads);
+    TICTACTOE::MiniMax::set_verbose(verbose);
+    // CPU time adds up over all threads, so unless told otherwise a threaded
+    // search measures the deadline on the wall clock
+    if (clock_name == "wall" || (clock_name.empty() && threads > 1))
+        TICTACTOE::Deadline::useClock(TICTACTOE::Deadline::WALL_TIME);
+
     // Start the game by sending the starting board without moves if the parameter "init" is given
     if (init)
     {
@@ -34,7 +73,7 @@ int main(int argc, char **argv)
         std::cout << message << std::endl;
     }
 
-    TICTACTOE::Player player;
+    TICTACTOE::Player player(database.isOpen() ? &database : NULL);
 
     std::string input_message;
     while (std::getline(std::cin, input_message))
@@ -101,6 +140,10 @@ int main(int argc, char **argv)
         //std::cerr << "Sending: '" << output_message << "'"<< std::endl;
         std::cout << output_message << std::endl;
 
+        // Think on the opponent's time, while waiting for its move
+        if (ponder && !output_state.getMove().isEOG())
+            TICTACTOE::MiniMax::start_pondering(output_state);
+
         // Quit if this is end of game
         if (output_state.getMove().isEOG())
             break;
@@ -1,73 +1,128 @@
 #include "minimax.h"
+#include "symmetry.hpp"
+
+#include <algorithm>
 
 namespace TICTACTOE
 {
-	const double MiniMax::TIME_BUFFER = 0.1;
+	static const double TIME_BUFFER = 0.1;
+	// A new iteration is only started when the previous one, scaled by this factor,
+	// still fits in the remaining time
+	static const double ITERATION_GROWTH = 4.0;
+	// Half the width of the aspiration window around the value of the previous iteration.
+	// Values of consecutive iterations differ by about 2, as the side that moves last
+	// gains a line. Won and lost values are never used as the centre.
+	static const int ASPIRATION_WINDOW = 3;
+	static const int ASPIRATION_LIMIT = INT_MAX / 2;
+
+	common::Search<MiniMax::Game> MiniMax::search;
+
+	void MiniMax::set_threads(int threads)
+	{
+		search.setThreads(threads);
+	}
+
+	void MiniMax::set_verbose(bool verbose)
+	{
+		search.setVerbose(verbose);
+	}
+
+	void MiniMax::start_pondering(const GameState& state)
+	{
+		search.startPondering(state);
+	}
+
+	GameState MiniMax::get_best_next_state(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type)
+	{
+		return GameState(current_state, search.bestMove(pDue, current_state, our_player_type));
+	}
+
+	int MiniMax::Game::packMove(const MoveList& moves, int index, int symmetry)
+	{
+		return Symmetry::map(symmetry, moves[index][0]);
+	}
+
+	int MiniMax::Game::unpackMove(const MoveList& moves, int packed, int symmetry)
+	{
+		return find_move(Symmetry::unmap(symmetry, packed), moves);
+	}
 
-	GameState MiniMax::minimax(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth)
+	int MiniMax::Game::aspirationWindow()
 	{
-		GameStateEvaluation eval = minimax(pDue, current_state, current_state.getNextPlayer() ^ (CELL_X | CELL_O), max_depth, 0, -INT_MAX, INT_MAX);
+		return ASPIRATION_WINDOW;
+	}
+
+	int MiniMax::Game::aspirationLimit()
+	{
+		return ASPIRATION_LIMIT;
+	}
+
+	double MiniMax::Game::timeMargin(int)
+	{
+		return TIME_BUFFER;
+	}
 
-		return eval.state;
+	double MiniMax::Game::iterationGrowth()
+	{
+		return ITERATION_GROWTH;
 	}
 
-	GameStateEvaluation MiniMax::minimax(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth, int depth, int alpha, int beta)
+	uint64_t MiniMax::transposition_key(const GameState& state, int& symmetry)
 	{
-		std::vector<GameState> possible_next_states;
-		current_state.findPossibleMoves(possible_next_states);
-		int num_next_moves = possible_next_states.size();
+		// The canonical board takes 2 bits per cell, which are spread over the whole key
+		// so that the table's buckets are picked by every cell
+		return Symmetry::canonicalKey(state, symmetry) * 0x9e3779b97f4a7c15ULL;
+	}
 
-		if (num_next_moves == 0 || depth == max_depth || pDue - Deadline::now() < TIME_BUFFER)
+	void MiniMax::remove_symmetric_moves(GameState& state, MoveList& moves)
+	{
+		// Moves leading to symmetric positions have the same value, keep the first of each
+		uint32_t keys[MoveList::cCapacity];
+		int num_keys = 0;
+		MoveList unique_moves;
+		GameState::UndoInfo undo;
+		for (int i = 0; i < moves.size(); ++i)
 		{
-			return{ current_state, evaluate_gamestate(current_state, our_player_type) };
+			state.doMove(moves[i], undo);
+			uint32_t key = Symmetry::canonicalKey(state);
+			state.undoMove(moves[i], undo);
+			if (std::find(keys, keys + num_keys, key) == keys + num_keys)
+			{
+				keys[num_keys++] = key;
+				unique_moves.push_back(moves[i]);
+			}
 		}
-		else
+		moves = unique_moves;
+	}
+
+	int MiniMax::find_move(int cell, const MoveList& moves)
+	{
+		for (int i = 0; i < moves.size(); ++i)
 		{
-			if (current_state.getNextPlayer() != our_player_type) //A
+			if (moves[i][0] == cell)
 			{
-				GameStateEvaluation best_next_state{ current_state, -INT_MAX };
-				for (GameState next_state : possible_next_states)
-				{
-					GameStateEvaluation next_state_eval = minimax(pDue, next_state, our_player_type, max_depth, depth + 1, alpha, beta);
-					if (next_state_eval.value > best_next_state.value)
-					{
-						best_next_state = GameStateEvaluation{ next_state, next_state_eval.value };
-					}
-					if (best_next_state.value > alpha)
-					{
-						alpha = best_next_state.value;
-					}
-
-					if (beta <= alpha &&  pDue - Deadline::now() < TIME_BUFFER)
-						break;
-				}
-				return best_next_state;
+				return i;
 			}
-			else //B
+		}
+		return -1;
+	}
+
+	int MiniMax::count_empty(const GameState& state)
+	{
+		int empty = 0;
+		for (int i = 0; i < state.cSquares; ++i)
+		{
+			if (state.at(i) == CELL_EMPTY)
 			{
-				GameStateEvaluation best_next_state{ current_state, INT_MAX };
-				for (GameState next_state : possible_next_states)
-				{
-					GameStateEvaluation next_state_eval = minimax(pDue, next_state, our_player_type, max_depth, depth + 1, alpha, beta);
-					if (next_state_eval.value < best_next_state.value)
-					{
-						best_next_state = GameStateEvaluation{ next_state, next_state_eval.value };
-					}
-					if (next_state_eval.value < beta)
-					{
-						beta = next_state_eval.value;
-					}
-					if (beta <= alpha &&  pDue - Deadline::now() < TIME_BUFFER)
-						break;
-				}
-				return best_next_state;
+				++empty;
 			}
 		}
+		return empty;
 	}
 
 	int MiniMax::evaluate_gamestate(const GameState& game_state, const int our_player_type)
 	{
-		int win_lose_scalar = 5;
+		int win_lose_scalar = INT_MAX;
 		if (game_state.isXWin())
 		{
 			if (our_player_type == CELL_X)
@@ -1,22 +1,57 @@
 #pragma once
 #include "gamestate.hpp"
-#include "deadline.hpp"
+#include "../common/search.hpp"
+#include <climits>
 namespace TICTACTOE
 {
-	struct GameStateEvaluation {
-		GameState state;
-		int value;
-	} typedef GameStateEvaluation;
+	using common::Deadline;
 
 	class MiniMax
 	{
-		static const double TIME_BUFFER;
 	public:
 
-		static GameState minimax(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth);
+		static GameState get_best_next_state(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type);
+		// Sets the number of threads the root moves are searched on
+		static void set_threads(int threads);
+		// Sets whether the searches log their progress to std::cerr
+		static void set_verbose(bool verbose);
+		// Searches, until the next move is asked for, the position after the reply expected
+		// to our move that led to state
+		static void start_pondering(const GameState& state);
 	private:
-		static GameStateEvaluation minimax(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth, int depth, int alpha, int beta);
 		static int evaluate_gamestate(const GameState& game_state, const int our_player_type);
+		// Symmetric positions share a key. Cells stored in the table are mapped by symmetry,
+		// the one that leads to the stored position.
+		static uint64_t transposition_key(const GameState& state, int& symmetry);
+		// Keeps one move of each class of moves leading to symmetric positions
+		static void remove_symmetric_moves(GameState& state, MoveList& moves);
+		static int find_move(int cell, const MoveList& moves);
+		static int count_empty(const GameState& state);
 
+		// The game as seen by the search (see common::Search). Values are from our point
+		// of view, and a won or lost game is worth INT_MAX or -INT_MAX.
+		struct Game
+		{
+			typedef TICTACTOE::GameState State;
+			typedef TICTACTOE::Move Move;
+			typedef TICTACTOE::MoveList MoveList;
+			typedef int Value;
+
+			static int evaluate(const GameState& state, uint8_t our_player_type) { return evaluate_gamestate(state, our_player_type); }
+			static bool isDecided(int value) { return value == INT_MAX || value == -INT_MAX; }
+			static bool probe(const GameState&, uint8_t, int&) { return false; }
+			static bool isQuiet(const GameState&) { return true; }
+			static uint64_t key(const GameState& state, int& symmetry) { return transposition_key(state, symmetry); }
+			static int packMove(const MoveList& moves, int index, int symmetry);
+			static int unpackMove(const MoveList& moves, int packed, int symmetry);
+			static void pruneRootMoves(GameState& state, MoveList& moves) { remove_symmetric_moves(state, moves); }
+			static int maxDepth(const GameState& state) { return count_empty(state); }
+			static int aspirationWindow();
+			static int aspirationLimit();
+			static double timeMargin(int threads);
+			static double iterationGrowth();
+		};
+
+		static common::Search<Game> search;
 	};
 }
\ No newline at end of file
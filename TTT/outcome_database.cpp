@@ -0,0 +1,181 @@
+#include "outcome_database.hpp"
+#include "symmetry.hpp"
+#include "../common/deadline.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace TICTACTOE
+{
+
+using common::Deadline;
+
+const char OutcomeDatabase::cMagic[8] = { 'T', 'T', 'T', '4', 'S', 'O', 'L', 'V' };
+
+///orders the outcomes of the moves of a position: the fastest win first, the
+///slowest loss last
+static int score(int pOutcome, int pPlies)
+{
+	if (pOutcome == OutcomeDatabase::WIN)
+		return 100 - pPlies;
+	if (pOutcome == OutcomeDatabase::LOSS)
+		return pPlies - 100;
+	return 0;
+}
+
+OutcomeDatabase::Entry OutcomeDatabase::solve(GameState &pState, std::unordered_map<uint32_t, Entry> &pSolved)
+{
+	int lSymmetry;
+	uint32_t lKey = Symmetry::canonicalKey(pState, lSymmetry);
+	std::unordered_map<uint32_t, Entry>::const_iterator lFound = pSolved.find(lKey);
+	if (lFound != pSolved.end())
+		return lFound->second;
+
+	MoveList lMoves;
+	pState.generateMoves(lMoves);
+	assert(!lMoves.empty());
+
+	Entry lBest;
+	std::memset(&lBest, 0, sizeof(lBest));
+	lBest.mKey = lKey;
+	int lBestScore = 0;
+	int lBestMove = -1;
+	GameState::UndoInfo lUndo;
+	for (int i = 0; i < lMoves.size(); ++i)
+	{
+		uint8_t lMover = lMoves[i][1];
+		pState.doMove(lMoves[i], lUndo);
+		int lOutcome;
+		int lPlies;
+		if (pState.isEOG())
+		{
+			bool lWon = (pState.isXWin() && lMover == CELL_X) || (pState.isOWin() && lMover == CELL_O);
+			lOutcome = lWon ? WIN : (pState.isXWin() || pState.isOWin()) ? LOSS : DRAW;
+			lPlies = 1;
+		}
+		else
+		{
+			Entry lReply = solve(pState, pSolved);
+			lOutcome = -lReply.mOutcome;
+			lPlies = lReply.mPlies + 1;
+		}
+		pState.undoMove(lMoves[i], lUndo);
+
+		if (lBestMove < 0 || score(lOutcome, lPlies) > lBestScore)
+		{
+			lBestScore = score(lOutcome, lPlies);
+			lBestMove = i;
+			lBest.mOutcome = (int8_t)lOutcome;
+			lBest.mPlies = (uint8_t)lPlies;
+		}
+	}
+
+	// The move is stored on the canonical board, so that it applies to every
+	// position with the same key
+	lBest.mCell = (uint8_t)Symmetry::map(lSymmetry, lMoves[lBestMove][0]);
+	pSolved[lKey] = lBest;
+	return lBest;
+}
+
+bool OutcomeDatabase::generate(const std::string &pPath)
+{
+	Deadline lStart = Deadline::now();
+	std::unordered_map<uint32_t, Entry> lSolved;
+	GameState lState;
+	Entry lRoot = solve(lState, lSolved);
+
+	Header lHeader;
+	std::memset(&lHeader, 0, sizeof(lHeader));
+	std::memcpy(lHeader.mMagic, cMagic, sizeof(cMagic));
+	lHeader.mVersion = cVersion;
+	lHeader.mBits = 1;
+	while ((1U << lHeader.mBits) < 2 * lSolved.size())
+		++lHeader.mBits;
+	lHeader.mCount = (uint32_t)lSolved.size();
+
+	// At most half the slots are used, so runs of full slots stay short
+	Entry lEmpty;
+	std::memset(&lEmpty, 0, sizeof(lEmpty));
+	lEmpty.mKey = cEmptyKey;
+	std::vector<Entry> lSlots(1U << lHeader.mBits, lEmpty);
+	uint32_t lMask = (1U << lHeader.mBits) - 1;
+	for (std::unordered_map<uint32_t, Entry>::const_iterator it = lSolved.begin(); it != lSolved.end(); ++it)
+	{
+		uint32_t lSlot = slot(it->first, lHeader.mBits);
+		while (lSlots[lSlot].mKey != cEmptyKey)
+			lSlot = (lSlot + 1) & lMask;
+		lSlots[lSlot] = it->second;
+	}
+
+	std::ofstream lFile(pPath.c_str(), std::ios::binary | std::ios::trunc);
+	lFile.write(reinterpret_cast<const char*>(&lHeader), sizeof(lHeader));
+	lFile.write(reinterpret_cast<const char*>(&lSlots[0]), lSlots.size() * sizeof(Entry));
+	lFile.close();
+	if (!lFile)
+		return false;
+
+	static const char *cOutcomes[] = { "loss", "draw", "win" };
+	std::cerr << "solved:" << lSolved.size() << " positions:first player " << cOutcomes[lRoot.mOutcome + 1]
+	          << " in " << (int)lRoot.mPlies << " plies:time:" << Deadline::now() - lStart << std::endl;
+	return true;
+}
+
+bool OutcomeDatabase::open(const std::string &pPath)
+{
+	mSlots = NULL;
+	if (!mFile.open(pPath))
+		return false;
+
+	Header lHeader;
+	if (mFile.size() < sizeof(lHeader))
+		return false;
+	std::memcpy(&lHeader, mFile.data(), sizeof(lHeader));
+	if (std::memcmp(lHeader.mMagic, cMagic, sizeof(cMagic)) != 0 || lHeader.mVersion != cVersion
+		|| lHeader.mBits < 1 || lHeader.mBits > 31
+		|| mFile.size() != sizeof(lHeader) + ((std::size_t)1 << lHeader.mBits) * sizeof(Entry))
+	{
+		mFile.close();
+		return false;
+	}
+
+	mSlots = reinterpret_cast<const Entry*>(mFile.data() + sizeof(lHeader));
+	mBits = lHeader.mBits;
+	return true;
+}
+
+bool OutcomeDatabase::probe(const GameState &pState, Result &pResult) const
+{
+	if (!mSlots)
+		return false;
+
+	int lSymmetry;
+	uint32_t lKey = Symmetry::canonicalKey(pState, lSymmetry);
+	uint32_t lMask = (1U << mBits) - 1;
+	uint32_t lSlot = slot(lKey, mBits);
+	while (mSlots[lSlot].mKey != lKey)
+	{
+		if (mSlots[lSlot].mKey == cEmptyKey)
+			return false;
+		lSlot = (lSlot + 1) & lMask;
+	}
+
+	// Take the move back from the canonical board to this one
+	const Entry &lEntry = mSlots[lSlot];
+	int lCell = Symmetry::unmap(lSymmetry, lEntry.mCell);
+	MoveList lMoves;
+	pState.generateMoves(lMoves);
+	for (int i = 0; i < lMoves.size(); ++i)
+	{
+		if (lMoves[i][0] == lCell)
+		{
+			pResult.mOutcome = (EOutcome)lEntry.mOutcome;
+			pResult.mPlies = lEntry.mPlies;
+			pResult.mMove = lMoves[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+/*namespace TICTACTOE*/ }
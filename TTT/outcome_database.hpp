@@ -0,0 +1,105 @@
+#ifndef _TICTACTOE_OUTCOME_DATABASE_HPP_
+#define _TICTACTOE_OUTCOME_DATABASE_HPP_
+
+#include "gamestate.hpp"
+#include "../common/mapped_file.hpp"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+namespace TICTACTOE {
+
+/**
+ * The solved game: the outcome of every reachable position with perfect play
+ *
+ * generate() plays out every game from the starting board, with symmetric
+ * positions (see Symmetry) solved once, and writes for each position where a
+ * move is to be made whether the player to move wins, draws or loses, in how
+ * many plies, and the move that gets there: the fastest win, or the slowest
+ * loss. open() maps such a file, and probe() looks a position up in it.
+ *
+ * The file is a Header followed by a hash table of Entry slots indexed by
+ * the canonical key of the position, with linear probing, so a probe reads
+ * one or two slots. Numbers are stored in the byte order of the machine that
+ * generated the file.
+ */
+class OutcomeDatabase
+{
+public:
+    enum EOutcome
+    {
+        LOSS = -1,      ///< the player to move loses
+        DRAW = 0,       ///< the game is drawn
+        WIN = 1         ///< the player to move wins
+    };
+
+    ///the result of a probe
+    struct Result
+    {
+        EOutcome mOutcome;  ///< for the player to move
+        int mPlies;         ///< the number of moves left until the game ends
+        Move mMove;         ///< the move to play
+    };
+
+    OutcomeDatabase()
+        :   mSlots(NULL)
+        ,   mBits(0)
+    {
+    }
+
+    ///solves the game and writes the database to \p pPath, returns false if
+    ///the file cannot be written
+    static bool generate(const std::string &pPath);
+
+    ///maps the database at \p pPath, returns false if it is missing or invalid
+    bool open(const std::string &pPath);
+
+    ///returns true while a database is mapped
+    bool isOpen() const    {    return mSlots != NULL;    }
+
+    ///looks up \p pState, which must not be the end of the game, returns false
+    ///if it is not in the database
+    bool probe(const GameState &pState, Result &pResult) const;
+
+private:
+    struct Header
+    {
+        char mMagic[8];         ///< cMagic
+        uint32_t mVersion;      ///< cVersion
+        uint32_t mBits;         ///< the table has 2^mBits slots
+        uint32_t mCount;        ///< the number of positions stored
+        uint32_t mReserved;
+    };
+
+    struct Entry
+    {
+        uint32_t mKey;          ///< the canonical key, cEmptyKey in empty slots
+        int8_t mOutcome;        ///< an EOutcome
+        uint8_t mPlies;         ///< plies until the end of the game
+        uint8_t mCell;          ///< the best move, on the canonical board
+        uint8_t mReserved;
+    };
+
+    static const char cMagic[8];
+    static const uint32_t cVersion = 1;
+    ///no position has this key, as no cell is ever 3
+    static const uint32_t cEmptyKey = 0xffffffffU;
+
+    ///returns the first slot to look for \p pKey in, in a table of 2^\p pBits slots
+    static uint32_t slot(uint32_t pKey, uint32_t pBits)
+    {
+        return (uint32_t)(pKey * 2654435761U) >> (32 - pBits);
+    }
+
+    ///returns the entry of \p pState, solving it and the positions after it
+    ///unless they are already in \p pSolved
+    static Entry solve(GameState &pState, std::unordered_map<uint32_t, Entry> &pSolved);
+
+    common::MappedFile mFile;
+    const Entry *mSlots;
+    uint32_t mBits;
+};
+
+/*namespace TICTACTOE*/ }
+
+#endif
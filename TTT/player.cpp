@@ -26,7 +26,16 @@ namespace TICTACTOE
 		 * next state. This skeleton returns a random move instead.
 		 */
 
-		GameState best_move = MiniMax::minimax(pDue, pState, pState.getNextPlayer() ^ (CELL_X | CELL_O), 4);
+		// With the solved game every move is a lookup
+		OutcomeDatabase::Result solved;
+		if (mDatabase && mDatabase->probe(pState, solved))
+		{
+			static const char *outcomes[] = { "loss", "draw", "win" };
+			cerr << "database:" << outcomes[solved.mOutcome + 1] << ":plies:" << solved.mPlies << endl;
+			return GameState(pState, solved.mMove);
+		}
+
+		GameState best_move = MiniMax::get_best_next_state(pDue, pState, pState.getNextPlayer() ^ (CELL_X | CELL_O));
 
 		assert(pState.getNextPlayer() != best_move.getNextPlayer());
 
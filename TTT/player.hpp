@@ -2,22 +2,34 @@
 #define _TICTACTOE_PLAYER_HPP_
 
 #include "constants.hpp"
-#include "deadline.hpp"
+#include "../common/deadline.hpp"
 #include "move.hpp"
 #include "gamestate.hpp"
+#include "outcome_database.hpp"
 #include <vector>
 
 namespace TICTACTOE
 {
 
+using common::Deadline;
+
 class Player
 {
 public:
+    ///\param pDatabase the solved game to play from, or NULL to search every move
+    explicit Player(const OutcomeDatabase *pDatabase = NULL)
+        :   mDatabase(pDatabase)
+    {
+    }
+
     ///perform a move
     ///\param pState the current state of the board
     ///\param pDue time before which we must have returned
     ///\return the next state the board is in after our move
     GameState play(const GameState &pState, const Deadline &pDue);
+
+private:
+    const OutcomeDatabase *mDatabase;
 };
 
 /*namespace TICTACTOE*/ }
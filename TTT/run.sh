@@ -3,7 +3,7 @@
 # javac HelloWorld.java; 
 # java Helloworld;
 
-if g++ *.cpp -Wall -std=c++11 -o TTT.exe;
+if g++ *.cpp -Wall -std=c++11 -pthread -o TTT.exe;
 then
    echo "Compilation successful!"
     ./TTT.exe init verbose < pipe | ./TTT.exe > pipe
@@ -0,0 +1,102 @@
+#include "symmetry.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TICTACTOE
+{
+
+const Symmetry::Tables Symmetry::sTables;
+
+/**
+ * Finds the symmetries by brute force
+ *
+ * Every candidate optionally transposes the board and then relabels rows and
+ * columns with a bijection of {0, 1, 2, 3} each; the ones that map all winning
+ * lines to winning lines are kept. Candidates are enumerated starting from the
+ * identity.
+ */
+Symmetry::Tables::Tables()
+{
+	static const int cNumLines = 10;
+	static const int cLines[cNumLines][4] = {
+		{ 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 8, 9, 10, 11 }, { 12, 13, 14, 15 },
+		{ 0, 4, 8, 12 }, { 1, 5, 9, 13 }, { 2, 6, 10, 14 }, { 3, 7, 11, 15 },
+		{ 0, 5, 10, 15 }, { 3, 6, 9, 12 }
+	};
+	int lLines[cNumLines];
+	for (int i = 0; i < cNumLines; ++i)
+	{
+		lLines[i] = 0;
+		for (int j = 0; j < 4; ++j)
+			lLines[i] |= 1 << cLines[i][j];
+	}
+	std::sort(lLines, lLines + cNumLines);
+
+	int lCount = 0;
+	for (int lTranspose = 0; lTranspose < 2; ++lTranspose)
+	{
+		int lRows[4] = { 0, 1, 2, 3 };
+		do
+		{
+			int lCols[4] = { 0, 1, 2, 3 };
+			do
+			{
+				uint8_t lMap[GameState::cSquares];
+				for (int lCell = 0; lCell < GameState::cSquares; ++lCell)
+				{
+					int lR = lRows[lCell >> 2];
+					int lC = lCols[lCell & 3];
+					lMap[lCell] = (uint8_t)(lTranspose ? lC * 4 + lR : lR * 4 + lC);
+				}
+
+				bool lPreserves = true;
+				for (int i = 0; i < cNumLines && lPreserves; ++i)
+				{
+					int lMapped = 0;
+					for (int j = 0; j < 4; ++j)
+						lMapped |= 1 << lMap[cLines[i][j]];
+					lPreserves = std::binary_search(lLines, lLines + cNumLines, lMapped);
+				}
+
+				if (lPreserves)
+				{
+					assert(lCount < cNumSymmetries);
+					for (int lCell = 0; lCell < GameState::cSquares; ++lCell)
+					{
+						mMap[lCount][lCell] = lMap[lCell];
+						mUnmap[lCount][lMap[lCell]] = (uint8_t)lCell;
+					}
+					++lCount;
+				}
+			} while (std::next_permutation(lCols, lCols + 4));
+		} while (std::next_permutation(lRows, lRows + 4));
+	}
+
+	assert(lCount == cNumSymmetries);
+}
+
+uint32_t Symmetry::canonicalKey(const GameState &pState)
+{
+	int lSymmetry;
+	return canonicalKey(pState, lSymmetry);
+}
+
+uint32_t Symmetry::canonicalKey(const GameState &pState, int &pSymmetry)
+{
+	uint32_t lBest = 0xffffffff;
+	for (int s = 0; s < cNumSymmetries; ++s)
+	{
+		uint32_t lKey = 0;
+		for (int lCell = 0; lCell < GameState::cSquares; ++lCell)
+			lKey |= (uint32_t)pState.at(lCell) << (2 * sTables.mMap[s][lCell]);
+		if (lKey < lBest)
+		{
+			lBest = lKey;
+			pSymmetry = s;
+		}
+	}
+	return lBest;
+}
+
+/*namespace TICTACTOE*/ }
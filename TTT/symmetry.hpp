@@ -0,0 +1,58 @@
+#ifndef _TICTACTOE_SYMMETRY_HPP_
+#define _TICTACTOE_SYMMETRY_HPP_
+
+#include "gamestate.hpp"
+#include <stdint.h>
+
+namespace TICTACTOE {
+
+/**
+ * The symmetries of the 4x4 board
+ *
+ * These are the permutations of the cells that map every winning line (rows,
+ * columns and both diagonals) to a winning line. Besides the 8 rotations and
+ * reflections of the square there are the maps that swap inner and outer rows
+ * and columns at the same time, 32 in total. Symmetric positions have the same
+ * value, so the search only needs to try one move of each class of equivalent
+ * moves.
+ *
+ * Symmetry 0 is the identity.
+ */
+class Symmetry
+{
+public:
+    static const int cNumSymmetries = 32;
+
+    ///returns the cell that symmetry \p pSymmetry maps \p pCell to
+    static int map(int pSymmetry, int pCell)        {    return sTables.mMap[pSymmetry][pCell];    }
+
+    ///returns the cell that symmetry \p pSymmetry maps to \p pCell
+    static int unmap(int pSymmetry, int pCell)      {    return sTables.mUnmap[pSymmetry][pCell];    }
+
+    /**
+     * Returns a key which is the same for all symmetric boards
+     *
+     * The board of \p pState is transformed by every symmetry and the smallest
+     * encoding (2 bits per cell) is returned.
+     */
+    static uint32_t canonicalKey(const GameState &pState);
+
+    ///as above, and sets \p pSymmetry to the symmetry that maps the board to
+    ///the one that was encoded
+    static uint32_t canonicalKey(const GameState &pState, int &pSymmetry);
+
+private:
+    struct Tables
+    {
+        Tables();
+
+        uint8_t mMap[cNumSymmetries][GameState::cSquares];
+        uint8_t mUnmap[cNumSymmetries][GameState::cSquares];
+    };
+
+    static const Tables sTables;
+};
+
+/*namespace TICTACTOE*/ }
+
+#endif
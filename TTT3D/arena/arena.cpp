@@ -0,0 +1,389 @@
+#include "../minimax.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Plays two configurations of the engine against each other in one process
+ *
+ * Each worker thread takes the next opening, a few random plies from the
+ * starting board, and plays it twice, once with each engine as X. Every engine
+ * is searched on the worker thread only, and by default its time is the CPU
+ * time of that thread, so games running at once on fewer cores than threads
+ * do not steal time from each other. A move played after its deadline loses
+ * the game, like in a real match.
+ *
+ * The score of engine A is turned into an Elo difference, and a sequential
+ * probability ratio test (SPRT) between the hypotheses elo0 and elo1 stops the
+ * match as soon as one of them is accepted.
+ */
+
+namespace TICTACTOE3D {
+
+///the settings of one of the engines
+struct Config
+{
+    double mTime;           ///< the time per move, in seconds
+    std::size_t mHash;      ///< the size of the transposition table, in megabytes
+    int mThreads;           ///< the threads each search runs on
+};
+
+///an engine the arena plays with
+class Engine
+{
+public:
+    virtual ~Engine()    {}
+
+    ///forgets the previous game
+    virtual void newGame() = 0;
+
+    ///returns the best move of \p pOurPlayer from \p pState, searched until shortly before \p pDue
+    virtual Move bestMove(const Deadline &pDue, const GameState &pState, uint8_t pOurPlayer) = 0;
+
+    ///returns the number of nodes the last search visited
+    virtual uint64_t getNodes() const = 0;
+};
+
+///an engine searching \p tGame. Searches of different games do not share
+///their per-thread move ordering tables.
+template <class tGame>
+class SearchEngine : public Engine
+{
+public:
+    explicit SearchEngine(const Config &pConfig)
+    {
+        mSearch.setHashSize(pConfig.mHash);
+        mSearch.setThreads(pConfig.mThreads);
+        mSearch.setVerbose(false);
+    }
+
+    void newGame()    {    mSearch.newGame();    }
+
+    Move bestMove(const Deadline &pDue, const GameState &pState, uint8_t pOurPlayer)
+    {
+        return mSearch.bestMove(pDue, pState, pOurPlayer);
+    }
+
+    uint64_t getNodes() const    {    return mSearch.getNodes();    }
+
+private:
+    common::Search<tGame> mSearch;
+};
+
+///the game searched by engine \p tEngine. Both engines play the same game;
+///a change to try out goes in one of them, e.g. by overriding evaluate().
+template <int tEngine>
+struct ArenaGame : public MiniMax::Game
+{
+};
+
+///how an engine used its time
+struct Usage
+{
+    Usage()
+        :   mMoves(0)
+        ,   mNodes(0)
+        ,   mTime(0)
+        ,   mMaxTime(0)
+        ,   mLate(0)
+    {
+    }
+
+    void add(const Usage &pOther)
+    {
+        mMoves += pOther.mMoves;
+        mNodes += pOther.mNodes;
+        mTime += pOther.mTime;
+        mMaxTime = std::max(mMaxTime, pOther.mMaxTime);
+        mLate += pOther.mLate;
+    }
+
+    uint64_t mMoves;
+    uint64_t mNodes;
+    double mTime;           ///< the time of all moves, in seconds
+    double mMaxTime;        ///< the time of the longest move
+    uint64_t mLate;         ///< the moves played after their deadline
+};
+
+///the results of the match, from the point of view of engine A
+struct Results
+{
+    Results()
+        :   mWins(0)
+        ,   mDraws(0)
+        ,   mLosses(0)
+    {
+    }
+
+    int getGames() const    {    return mWins + mDraws + mLosses;    }
+
+    ///returns the average score of a game, 1 for a win and 0.5 for a draw
+    double getScore() const    {    return (mWins + 0.5 * mDraws) / getGames();    }
+
+    ///returns the variance of the score of a game
+    double getVariance() const
+    {
+        double lScore = getScore();
+        return (mWins * (1 - lScore) * (1 - lScore) + mDraws * (0.5 - lScore) * (0.5 - lScore)
+                + mLosses * lScore * lScore) / getGames();
+    }
+
+    int mWins;
+    int mDraws;
+    int mLosses;
+    Usage mUsage[2];
+};
+
+///returns the Elo difference that gives the score \p pScore
+static double scoreToElo(double pScore)
+{
+    pScore = std::min(std::max(pScore, 1e-6), 1 - 1e-6);
+    return -400 * std::log10(1 / pScore - 1);
+}
+
+///returns the score of an Elo difference of \p pElo
+static double eloToScore(double pElo)
+{
+    return 1 / (1 + std::pow(10, -pElo / 400));
+}
+
+///returns the log-likelihood ratio of the hypotheses that A is \p pElo1 rather
+///than \p pElo0 Elo stronger, with the scores approximated by normal laws
+static double logLikelihoodRatio(const Results &pResults, double pElo0, double pElo1)
+{
+    double lVariance = pResults.getVariance();
+    if (pResults.getGames() == 0 || lVariance <= 0)
+        return 0;
+    double lScore0 = eloToScore(pElo0);
+    double lScore1 = eloToScore(pElo1);
+    return pResults.getGames() * (lScore1 - lScore0) * (2 * pResults.getScore() - lScore0 - lScore1) / (2 * lVariance);
+}
+
+///plays \p pPlies random moves from the starting board
+static GameState randomOpening(std::mt19937 &pRandom, int pPlies)
+{
+    GameState lState;
+    MoveList lMoves;
+    for (int i = 0; i < pPlies && !lState.isEOG(); ++i)
+    {
+        lState.generateMoves(lMoves);
+        lState = GameState(lState, lMoves[pRandom() % lMoves.size()]);
+    }
+    return lState;
+}
+
+///plays a game from \p pOpening between \p pX and \p pO, returns the winner
+///(CELL_X or CELL_O) or 0 for a draw
+static uint8_t playGame(const GameState &pOpening, Engine *pX, Engine *pO, const Config &pXConfig,
+                        const Config &pOConfig, Usage &pXUsage, Usage &pOUsage)
+{
+    pX->newGame();
+    pO->newGame();
+    GameState lState = pOpening;
+    while (!lState.isEOG())
+    {
+        // The player that moved last is the one getNextPlayer() returns
+        uint8_t lPlayer = lState.getNextPlayer() ^ (CELL_X | CELL_O);
+        Engine *lEngine = lPlayer == CELL_X ? pX : pO;
+        Usage &lUsage = lPlayer == CELL_X ? pXUsage : pOUsage;
+
+        Deadline lStart = Deadline::now();
+        Deadline lDue = lStart + (lPlayer == CELL_X ? pXConfig : pOConfig).mTime;
+        Move lMove = lEngine->bestMove(lDue, lState, lPlayer);
+        Deadline lEnd = Deadline::now();
+
+        ++lUsage.mMoves;
+        lUsage.mNodes += lEngine->getNodes();
+        lUsage.mTime += lEnd - lStart;
+        lUsage.mMaxTime = std::max(lUsage.mMaxTime, lEnd - lStart);
+        if (lEnd > lDue)
+        {
+            ++lUsage.mLate;
+            return lPlayer ^ (CELL_X | CELL_O);
+        }
+        lState = GameState(lState, lMove);
+    }
+    return lState.isXWin() ? CELL_X : lState.isOWin() ? CELL_O : 0;
+}
+
+/*namespace TICTACTOE3D*/ }
+
+using namespace TICTACTOE3D;
+
+static void printResults(const Results &pResults, double pElo0, double pElo1, double pLower, double pUpper)
+{
+    int lGames = pResults.getGames();
+    double lScore = pResults.getScore();
+    // The 95% confidence interval of the score, turned into Elo
+    double lError = 1.96 * std::sqrt(pResults.getVariance() / lGames);
+    double lLlr = logLikelihoodRatio(pResults, pElo0, pElo1);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "games " << lGames << ": W " << pResults.mWins << " D " << pResults.mDraws << " L " << pResults.mLosses
+              << "  score " << std::setprecision(3) << lScore
+              << "  elo " << std::setprecision(1) << scoreToElo(lScore)
+              << " [" << scoreToElo(lScore - lError) << ", " << scoreToElo(lScore + lError) << "]"
+              << "  llr " << std::setprecision(2) << lLlr << " (" << pLower << ", " << pUpper << ")" << std::endl;
+    for (int e = 0; e < 2; ++e)
+    {
+        const Usage &lUsage = pResults.mUsage[e];
+        std::cout << "  " << (e == 0 ? 'A' : 'B') << ": moves " << lUsage.mMoves
+                  << "  nodes/s " << (long)(lUsage.mTime > 0 ? lUsage.mNodes / lUsage.mTime : 0)
+                  << "  time/move " << std::setprecision(3) << (lUsage.mMoves ? lUsage.mTime / lUsage.mMoves : 0)
+                  << "  max " << lUsage.mMaxTime << "  late " << lUsage.mLate << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // Parse parameters
+    Config configs[2] = { { 0.5, 16, 1 }, { 0.5, 16, 1 } };
+    int games = 1000;
+    int threads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+    int opening_plies = 2;
+    unsigned seed = 1;
+    double elo0 = 0;
+    double elo1 = 10;
+    double alpha = 0.05;
+    double beta = 0.05;
+    std::string clock_name;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string param(argv[i]);
+        // Engine settings apply to both engines, or to one with the prefix a_ or b_
+        int first = 0;
+        int last = 1;
+        if (param.size() > 2 && (param[0] == 'a' || param[0] == 'b') && param[1] == '_')
+        {
+            first = last = param[0] == 'a' ? 0 : 1;
+            param = param.substr(2);
+        }
+
+        if (param == "time" && i + 1 < argc)
+        {
+            for (int e = first; e <= last; ++e)
+                configs[e].mTime = atof(argv[i + 1]);
+            ++i;
+        }
+        else if (param == "hash" && i + 1 < argc)
+        {
+            for (int e = first; e <= last; ++e)
+                configs[e].mHash = atoi(argv[i + 1]);
+            ++i;
+        }
+        else if (param == "search_threads" && i + 1 < argc)
+        {
+            for (int e = first; e <= last; ++e)
+                configs[e].mThreads = std::max(atoi(argv[i + 1]), 1);
+            ++i;
+        }
+        else if (first == last)
+        {
+            std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
+            return -1;
+        }
+        else if (param == "games" && i + 1 < argc)
+            games = atoi(argv[++i]);
+        else if (param == "threads" && i + 1 < argc)
+            threads = std::max(atoi(argv[++i]), 1);
+        else if (param == "openings" && i + 1 < argc)
+            opening_plies = atoi(argv[++i]);
+        else if (param == "seed" && i + 1 < argc)
+            seed = (unsigned)atoi(argv[++i]);
+        else if (param == "elo0" && i + 1 < argc)
+            elo0 = atof(argv[++i]);
+        else if (param == "elo1" && i + 1 < argc)
+            elo1 = atof(argv[++i]);
+        else if (param == "alpha" && i + 1 < argc)
+            alpha = atof(argv[++i]);
+        else if (param == "beta" && i + 1 < argc)
+            beta = atof(argv[++i]);
+        else if (param == "clock" && i + 1 < argc && (std::string(argv[i + 1]) == "thread" || std::string(argv[i + 1]) == "wall"))
+            clock_name = argv[++i];
+        else
+        {
+            std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
+            return -1;
+        }
+    }
+
+    // The CPU time of a worker thread misses the other threads of a threaded search
+    if (clock_name == "wall" || (clock_name.empty() && std::max(configs[0].mThreads, configs[1].mThreads) > 1))
+        Deadline::useClock(Deadline::WALL_TIME);
+    else
+        Deadline::useClock(Deadline::THREAD_TIME);
+
+    const double lower = std::log(beta / (1 - alpha));
+    const double upper = std::log((1 - beta) / alpha);
+    std::cout << "A: time " << configs[0].mTime << " hash " << configs[0].mHash << " search_threads " << configs[0].mThreads << std::endl;
+    std::cout << "B: time " << configs[1].mTime << " hash " << configs[1].mHash << " search_threads " << configs[1].mThreads << std::endl;
+    std::cout << "games " << games << " threads " << threads << " openings " << opening_plies << " plies"
+              << " sprt elo0 " << elo0 << " elo1 " << elo1 << " alpha " << alpha << " beta " << beta << std::endl;
+
+    // Each worker plays pairs of games, one with each engine as X, from the
+    // opening of the pair, until all are played or the test is decided
+    Results results;
+    std::mutex results_mutex;
+    std::atomic<int> next_pair(0);
+    std::atomic<bool> decided(false);
+    Deadline start(get_wall_time());
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            std::unique_ptr<Engine> engines[2] = {
+                std::unique_ptr<Engine>(new SearchEngine<ArenaGame<0> >(configs[0])),
+                std::unique_ptr<Engine>(new SearchEngine<ArenaGame<1> >(configs[1]))
+            };
+            for (int pair = next_pair++; 2 * pair < games && !decided; pair = next_pair++)
+            {
+                std::mt19937 random(seed + pair);
+                GameState opening = randomOpening(random, opening_plies);
+                for (int g = 0; g < 2 && 2 * pair + g < games; ++g)
+                {
+                    // Engine A plays X in the first game of the pair
+                    int x = g;
+                    Usage usage[2];
+                    uint8_t winner = playGame(opening, engines[x].get(), engines[1 - x].get(),
+                                              configs[x], configs[1 - x], usage[x], usage[1 - x]);
+
+                    std::lock_guard<std::mutex> lock(results_mutex);
+                    uint8_t a_player = x == 0 ? CELL_X : CELL_O;
+                    if (winner == a_player)
+                        ++results.mWins;
+                    else if (winner == 0)
+                        ++results.mDraws;
+                    else
+                        ++results.mLosses;
+                    results.mUsage[0].add(usage[0]);
+                    results.mUsage[1].add(usage[1]);
+
+                    double llr = logLikelihoodRatio(results, elo0, elo1);
+                    if (results.getGames() % 100 == 0)
+                        printResults(results, elo0, elo1, lower, upper);
+                    if (llr <= lower || llr >= upper)
+                        decided = true;
+                }
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t)
+        workers[t].join();
+
+    printResults(results, elo0, elo1, lower, upper);
+    double llr = logLikelihoodRatio(results, elo0, elo1);
+    std::cout << "sprt: " << (llr >= upper ? "H1 accepted (elo1)" : llr <= lower ? "H0 accepted (elo0)" : "inconclusive")
+              << "  wall time " << std::setprecision(1) << Deadline(get_wall_time()) - start << " s" << std::endl;
+    return 0;
+}
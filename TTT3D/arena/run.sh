@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# Plays engine A against engine B in one process, e.g.
+#   ./run.sh games 2000 a_time 0.5 b_time 0.25 hash 16 elo0 0 elo1 20
+# Engine settings (time, hash, search_threads) apply to both engines, or to one
+# with the prefix a_ or b_. See arena.cpp for the other parameters.
+
+cd "$(dirname "$0")"
+if g++ -O2 arena.cpp $(ls ../*.cpp | grep -v '/main.cpp$') -Wall -std=c++11 -pthread -o arena.exe;
+then
+    ./arena.exe "$@"
+else
+    echo "Compilation failed."
+fi
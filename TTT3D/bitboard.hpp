@@ -0,0 +1,177 @@
+#ifndef _TICTACTOE3D_BITBOARD_HPP_
+#define _TICTACTOE3D_BITBOARD_HPP_
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace TICTACTOE3D {
+
+/**
+ * Bitboard helpers for the 4x4x4 cube.
+ *
+ * A board is stored as one uint64_t per player, where bit i is set if the
+ * player owns cell i (see GameState for the cell numbering).
+ */
+
+///number of lines of four cells that win the game
+static const int cNumLines = 76;
+
+///a cell is part of either 4 or 7 winning lines
+static const int cMaxLinesPerCell = 7;
+
+///all cells of the board
+static const uint64_t cFullBoard = ~0ULL;
+
+///the 76 winning lines, one bit per cell
+static constexpr uint64_t cWinningLines[cNumLines] = {
+	// 16 rows (fixed row and layer)
+	0x000000000000000fULL, 0x00000000000000f0ULL, 0x0000000000000f00ULL, 0x000000000000f000ULL,
+	0x00000000000f0000ULL, 0x0000000000f00000ULL, 0x000000000f000000ULL, 0x00000000f0000000ULL,
+	0x0000000f00000000ULL, 0x000000f000000000ULL, 0x00000f0000000000ULL, 0x0000f00000000000ULL,
+	0x000f000000000000ULL, 0x00f0000000000000ULL, 0x0f00000000000000ULL, 0xf000000000000000ULL,
+	// 16 columns (fixed column and layer)
+	0x0000000000001111ULL, 0x0000000000002222ULL, 0x0000000000004444ULL, 0x0000000000008888ULL,
+	0x0000000011110000ULL, 0x0000000022220000ULL, 0x0000000044440000ULL, 0x0000000088880000ULL,
+	0x0000111100000000ULL, 0x0000222200000000ULL, 0x0000444400000000ULL, 0x0000888800000000ULL,
+	0x1111000000000000ULL, 0x2222000000000000ULL, 0x4444000000000000ULL, 0x8888000000000000ULL,
+	// 16 pillars (fixed row and column, through all layers)
+	0x0001000100010001ULL, 0x0002000200020002ULL, 0x0004000400040004ULL, 0x0008000800080008ULL,
+	0x0010001000100010ULL, 0x0020002000200020ULL, 0x0040004000400040ULL, 0x0080008000800080ULL,
+	0x0100010001000100ULL, 0x0200020002000200ULL, 0x0400040004000400ULL, 0x0800080008000800ULL,
+	0x1000100010001000ULL, 0x2000200020002000ULL, 0x4000400040004000ULL, 0x8000800080008000ULL,
+	// 8 diagonals within a layer
+	0x0000000000008421ULL, 0x0000000000001248ULL, 0x0000000084210000ULL, 0x0000000012480000ULL,
+	0x0000842100000000ULL, 0x0000124800000000ULL, 0x8421000000000000ULL, 0x1248000000000000ULL,
+	// 8 diagonals within a row plane (column and layer vary)
+	0x0008000400020001ULL, 0x0001000200040008ULL, 0x0080004000200010ULL, 0x0010002000400080ULL,
+	0x0800040002000100ULL, 0x0100020004000800ULL, 0x8000400020001000ULL, 0x1000200040008000ULL,
+	// 8 diagonals within a column plane (row and layer vary)
+	0x1000010000100001ULL, 0x0001001001001000ULL, 0x2000020000200002ULL, 0x0002002002002000ULL,
+	0x4000040000400004ULL, 0x0004004004004000ULL, 0x8000080000800008ULL, 0x0008008008008000ULL,
+	// 4 space diagonals through the cube
+	0x8000040000200001ULL, 0x1000020000400008ULL, 0x0001002004008000ULL, 0x0008004002001000ULL,
+};
+
+///number of winning lines going through each cell
+static constexpr uint8_t cCellLineCount[64] = {
+	7, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 4, 7, 4, 4, 7,
+	4, 4, 4, 4, 4, 7, 7, 4, 4, 7, 7, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 7, 7, 4, 4, 7, 7, 4, 4, 4, 4, 4,
+	7, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 4, 7, 4, 4, 7,
+};
+
+///indices (into cWinningLines) of the lines going through each cell,
+///only the first cCellLineCount[cell] entries are valid
+static constexpr uint8_t cCellLines[64][cMaxLinesPerCell] = {
+	{  0, 16, 32, 48, 56, 64, 72 }, // 0
+	{  0, 17, 33, 66,  0,  0,  0 }, // 1
+	{  0, 18, 34, 68,  0,  0,  0 }, // 2
+	{  0, 19, 35, 49, 57, 70, 73 }, // 3
+	{  1, 16, 36, 58,  0,  0,  0 }, // 4
+	{  1, 17, 37, 48,  0,  0,  0 }, // 5
+	{  1, 18, 38, 49,  0,  0,  0 }, // 6
+	{  1, 19, 39, 59,  0,  0,  0 }, // 7
+	{  2, 16, 40, 60,  0,  0,  0 }, // 8
+	{  2, 17, 41, 49,  0,  0,  0 }, // 9
+	{  2, 18, 42, 48,  0,  0,  0 }, // 10
+	{  2, 19, 43, 61,  0,  0,  0 }, // 11
+	{  3, 16, 44, 49, 62, 65, 75 }, // 12
+	{  3, 17, 45, 67,  0,  0,  0 }, // 13
+	{  3, 18, 46, 69,  0,  0,  0 }, // 14
+	{  3, 19, 47, 48, 63, 71, 74 }, // 15
+	{  4, 20, 32, 50,  0,  0,  0 }, // 16
+	{  4, 21, 33, 56,  0,  0,  0 }, // 17
+	{  4, 22, 34, 57,  0,  0,  0 }, // 18
+	{  4, 23, 35, 51,  0,  0,  0 }, // 19
+	{  5, 20, 36, 64,  0,  0,  0 }, // 20
+	{  5, 21, 37, 50, 58, 66, 72 }, // 21
+	{  5, 22, 38, 51, 59, 68, 73 }, // 22
+	{  5, 23, 39, 70,  0,  0,  0 }, // 23
+	{  6, 20, 40, 65,  0,  0,  0 }, // 24
+	{  6, 21, 41, 51, 60, 67, 75 }, // 25
+	{  6, 22, 42, 50, 61, 69, 74 }, // 26
+	{  6, 23, 43, 71,  0,  0,  0 }, // 27
+	{  7, 20, 44, 51,  0,  0,  0 }, // 28
+	{  7, 21, 45, 62,  0,  0,  0 }, // 29
+	{  7, 22, 46, 63,  0,  0,  0 }, // 30
+	{  7, 23, 47, 50,  0,  0,  0 }, // 31
+	{  8, 24, 32, 52,  0,  0,  0 }, // 32
+	{  8, 25, 33, 57,  0,  0,  0 }, // 33
+	{  8, 26, 34, 56,  0,  0,  0 }, // 34
+	{  8, 27, 35, 53,  0,  0,  0 }, // 35
+	{  9, 24, 36, 65,  0,  0,  0 }, // 36
+	{  9, 25, 37, 52, 59, 67, 74 }, // 37
+	{  9, 26, 38, 53, 58, 69, 75 }, // 38
+	{  9, 27, 39, 71,  0,  0,  0 }, // 39
+	{ 10, 24, 40, 64,  0,  0,  0 }, // 40
+	{ 10, 25, 41, 53, 61, 66, 73 }, // 41
+	{ 10, 26, 42, 52, 60, 68, 72 }, // 42
+	{ 10, 27, 43, 70,  0,  0,  0 }, // 43
+	{ 11, 24, 44, 53,  0,  0,  0 }, // 44
+	{ 11, 25, 45, 63,  0,  0,  0 }, // 45
+	{ 11, 26, 46, 62,  0,  0,  0 }, // 46
+	{ 11, 27, 47, 52,  0,  0,  0 }, // 47
+	{ 12, 28, 32, 54, 57, 65, 74 }, // 48
+	{ 12, 29, 33, 67,  0,  0,  0 }, // 49
+	{ 12, 30, 34, 69,  0,  0,  0 }, // 50
+	{ 12, 31, 35, 55, 56, 71, 75 }, // 51
+	{ 13, 28, 36, 59,  0,  0,  0 }, // 52
+	{ 13, 29, 37, 54,  0,  0,  0 }, // 53
+	{ 13, 30, 38, 55,  0,  0,  0 }, // 54
+	{ 13, 31, 39, 58,  0,  0,  0 }, // 55
+	{ 14, 28, 40, 61,  0,  0,  0 }, // 56
+	{ 14, 29, 41, 55,  0,  0,  0 }, // 57
+	{ 14, 30, 42, 54,  0,  0,  0 }, // 58
+	{ 14, 31, 43, 60,  0,  0,  0 }, // 59
+	{ 15, 28, 44, 55, 63, 64, 73 }, // 60
+	{ 15, 29, 45, 66,  0,  0,  0 }, // 61
+	{ 15, 30, 46, 68,  0,  0,  0 }, // 62
+	{ 15, 31, 47, 54, 62, 70, 72 }, // 63
+};
+
+///returns the number of set bits in \p pBoard
+inline int popCount(uint64_t pBoard)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt64(pBoard);
+#else
+	return __builtin_popcountll(pBoard);
+#endif
+}
+
+///returns the index of the lowest set bit in \p pBoard (which must not be 0)
+inline int lowestBit(uint64_t pBoard)
+{
+#ifdef _MSC_VER
+	unsigned long lIndex;
+	_BitScanForward64(&lIndex, pBoard);
+	return (int)lIndex;
+#else
+	return __builtin_ctzll(pBoard);
+#endif
+}
+
+///returns the bitboard with only cell \p pCell set
+inline uint64_t cellBit(int pCell)
+{
+	return 1ULL << pCell;
+}
+
+///returns true if \p pBoard completes any winning line through \p pCell
+inline bool completesLine(uint64_t pBoard, int pCell)
+{
+	for (int i = 0; i < cCellLineCount[pCell]; ++i)
+	{
+		const uint64_t lLine = cWinningLines[cCellLines[pCell][i]];
+		if ((pBoard & lLine) == lLine)
+			return true;
+	}
+	return false;
+}
+
+/*namespace TICTACTOE3D*/ }
+
+#endif
@@ -6,16 +6,45 @@
 namespace TICTACTOE3D
 {
 
+/**
+ * The random keys of the Zobrist hash, one per player and cell
+ *
+ * They are generated with splitmix64 from a fixed seed, so keys are the same
+ * on every run.
+ */
+struct ZobristKeys
+{
+	uint64_t mPiece[2][GameState::cSquares];
+
+	ZobristKeys()
+	{
+		uint64_t lSeed = 0x3d7717ac0ffee64dULL;
+		for (int i = 0; i < 2; ++i)
+			for (int j = 0; j < GameState::cSquares; ++j)
+				mPiece[i][j] = next(lSeed);
+	}
+
+	static uint64_t next(uint64_t &pState)
+	{
+		uint64_t lZ = (pState += 0x9e3779b97f4a7c15ULL);
+		lZ = (lZ ^ (lZ >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		lZ = (lZ ^ (lZ >> 27)) * 0x94d049bb133111ebULL;
+		return lZ ^ (lZ >> 31);
+	}
+};
+
+static const ZobristKeys cZobrist;
+
 /**
  * Initializes the board to the starting position
  */
 GameState::GameState()
 {
 	// Initialize the board (empty)
-	for(int i=0;i<64;i++)
-	{
-		mCell[i]=CELL_EMPTY;
-	}	
+	mPieces[0] = 0;
+	mPieces[1] = 0;
+	initLines();
+	mHash = computeHash();
 	// Initialize move related variables
 	mLastMove = Move(Move::MOVE_BOG);
 	// Player X starts
@@ -38,17 +67,21 @@ GameState::GameState(const std::string &pMessage)
 	assert(next_player.size() == 1);
 	
 	// Parse the board
+	mPieces[0] = 0;
+	mPieces[1] = 0;
 	for (int i = 0; i < cSquares; ++i)
 	{
 		if (board[i] == MESSAGE_SYMBOLS[CELL_EMPTY])
-			mCell[i] = CELL_EMPTY;
+			continue;
 		else if (board[i] == MESSAGE_SYMBOLS[CELL_X])
-			mCell[i] = CELL_X;
+			mPieces[CELL_X - 1] |= cellBit(i);
 		else if (board[i] == MESSAGE_SYMBOLS[CELL_O])
-			mCell[i] = CELL_O;
+			mPieces[CELL_O - 1] |= cellBit(i);
 		else
 			assert("Invalid cell" && false);
 	}
+	initLines();
+	mHash = computeHash();
 
 	// Parse last move
 	mLastMove = Move(last_move);
@@ -79,7 +112,14 @@ GameState::GameState(const GameState &pRH,const Move &pMove)
 {
 
 	// Copy board
-    memcpy(mCell, pRH.mCell, sizeof(mCell));
+    mPieces[0] = pRH.mPieces[0];
+    mPieces[1] = pRH.mPieces[1];
+    memcpy(mLineCount, pRH.mLineCount, sizeof(mLineCount));
+    mLineValue[0]   = pRH.mLineValue[0];
+    mLineValue[1]   = pRH.mLineValue[1];
+    mOpenThrees[0]  = pRH.mOpenThrees[0];
+    mOpenThrees[1]  = pRH.mOpenThrees[1];
+    mHash           = pRH.mHash;
 
     // Copy move status
     mNextPlayer     = pRH.mNextPlayer;
@@ -99,51 +139,22 @@ GameState::GameState(const GameState &pRH,const Move &pMove)
  * who is not making the move
 
  */
-void GameState::tryMove(std::vector<Move> &pMoves, int pCell) const
+void GameState::tryMove(MoveList &pMoves, int pCell) const
 {
-    int lR=cellToRow(pCell);
-    int lC=cellToCol(pCell);
-	int lL=cellToLay(pCell);
-	int SpecialMove=0;
-	
-    // Try move X
-    if(mNextPlayer==CELL_X)
-    {
-        // Try move
-        if(at(lR,lC,lL)==CELL_EMPTY)
-		{
-			//Check if special move
-			SpecialMove = GameState::Special_Move(pCell,CELL_O);
-			
-			if(SpecialMove>0)
-			{
-				pMoves.push_back(Move(pCell,CELL_O,SpecialMove));
-			}
-			else
-			{
-				pMoves.push_back(Move(pCell,CELL_O)); 
-			}
-		}                   
-    }
-    // Try move O
-    if(mNextPlayer==CELL_O)
-    {
-        // Try move
-        if(at(lR,lC,lL)==CELL_EMPTY)
-		{
-			//Check if special move
-			SpecialMove = GameState::Special_Move(pCell,CELL_X);
-			
-			if(SpecialMove>0)
-			{
-				pMoves.push_back(Move(pCell,CELL_X,SpecialMove));
-			}
-			else
-			{
-				pMoves.push_back(Move(pCell,CELL_X)); 
-			}
-		}                  
-    }
+	// The piece placed is the one of the player who is not next
+	Cell lPlayer = (mNextPlayer == CELL_X) ? CELL_O : CELL_X;
+
+	//Check if special move
+	int SpecialMove = GameState::Special_Move(pCell, lPlayer);
+
+	if(SpecialMove>0)
+	{
+		pMoves.push_back(Move(pCell,lPlayer,SpecialMove));
+	}
+	else
+	{
+		pMoves.push_back(Move(pCell,lPlayer));
+	}
 }
 
 
@@ -158,21 +169,32 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
 {
     pStates.clear();
 
+    MoveList lMoves;
+    generateMoves(lMoves);
+
+    // Convert moves to GameStates
+    for (int i = 0; i < lMoves.size(); ++i)
+    	pStates.push_back(GameState(*this, lMoves[i]));
+}
+
+/**
+ * Returns the list of all valid moves in this state
+ *
+ * \param pMoves the list where the moves will be stored (it is cleared first)
+ */
+void GameState::generateMoves(MoveList &pMoves) const
+{
+    pMoves.clear();
+
     if (mLastMove.isEOG())
     	return;
 
-	std::vector<Move> lMoves;
-	
-    for (int k = 0; k < cSquares; ++k)
+    // Only the empty cells are tried, in increasing order
+    for (uint64_t lEmpty = getEmpty(); lEmpty; lEmpty &= lEmpty - 1)
     {
-        int lCell = k;       
-        tryMove(lMoves, lCell);		
-    }   
-	
-    // Convert moves to GameStates
-    for (unsigned i = 0; i < lMoves.size(); ++i)
-    	pStates.push_back(GameState(*this, lMoves[i]));	
-    
+        int lCell = lowestBit(lEmpty);
+        tryMove(pMoves, lCell);
+    }
 }
 
 /**
@@ -184,10 +206,14 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
  */
 void GameState::doMove(const Move &pMove)
 {
-   
-   // set the piece
-		at(pMove[0]) = pMove[1];
-    
+    // set the piece (moves without cells, such as the null move, only pass the turn)
+    if (pMove.length() > 0)
+    {
+        mPieces[pMove[1] - 1] |= cellBit(pMove[0]);
+        mHash ^= cZobrist.mPiece[pMove[1] - 1][pMove[0]];
+        updateLines(pMove[0], pMove[1], 1);
+    }
+
     // Remember last move
     mLastMove = pMove;
 
@@ -196,6 +222,101 @@ void GameState::doMove(const Move &pMove)
 
 }
 
+/**
+ * Takes back a move made with doMove(pMove, pUndo)
+ *
+ * \param pMove the move to take back
+ * \param pUndo the information stored by doMove
+ */
+void GameState::undoMove(const Move &pMove, const UndoInfo &pUndo)
+{
+    // remove the piece
+    if (pMove.length() > 0)
+    {
+        mPieces[pMove[1] - 1] &= ~cellBit(pMove[0]);
+        mHash ^= cZobrist.mPiece[pMove[1] - 1][pMove[0]];
+        updateLines(pMove[0], pMove[1], -1);
+    }
+
+    // Restore last move and player
+    mLastMove = pUndo.mLastMove;
+    mNextPlayer = mNextPlayer ^ (CELL_X | CELL_O);
+}
+
+/**
+ * Computes the hash key from scratch
+ */
+uint64_t GameState::computeHash() const
+{
+	uint64_t lHash = 0;
+	for (int i = 0; i < 2; ++i)
+		for (uint64_t lCells = mPieces[i]; lCells; lCells &= lCells - 1)
+			lHash ^= cZobrist.mPiece[i][lowestBit(lCells)];
+	return lHash;
+}
+
+/**
+ * Updates the per-line counters after \p pPlayer has been given (\p pDelta = 1)
+ * or has lost (\p pDelta = -1) cell \p pCell
+ *
+ * Only the 4 to 7 lines going through the cell are touched.
+ */
+void GameState::updateLines(int pCell, uint8_t pPlayer, int pDelta)
+{
+	const int lOwn = pPlayer - 1;
+	const int lOther = lOwn ^ 1;
+
+	for (int i = 0; i < cCellLineCount[pCell]; ++i)
+	{
+		const int lLine = cCellLines[pCell][i];
+		uint8_t &lOwnCount = mLineCount[lOwn][lLine];
+		const uint8_t lOtherCount = mLineCount[lOther][lLine];
+
+		// Take the line out of both sums...
+		mLineValue[lOwn] -= lineValue(lOwnCount, lOtherCount);
+		mLineValue[lOther] -= lineValue(lOtherCount, lOwnCount);
+		if (lOwnCount == 3 && lOtherCount == 0)
+			--mOpenThrees[lOwn];
+		if (lOtherCount == 3 && lOwnCount == 0)
+			--mOpenThrees[lOther];
+
+		lOwnCount += pDelta;
+
+		// ...and put it back with the new count
+		mLineValue[lOwn] += lineValue(lOwnCount, lOtherCount);
+		mLineValue[lOther] += lineValue(lOtherCount, lOwnCount);
+		if (lOwnCount == 3 && lOtherCount == 0)
+			++mOpenThrees[lOwn];
+		if (lOtherCount == 3 && lOwnCount == 0)
+			++mOpenThrees[lOther];
+	}
+}
+
+/**
+ * Recomputes all per-line counters from the bitboards
+ */
+void GameState::initLines()
+{
+	for (int p = 0; p < 2; ++p)
+	{
+		mLineValue[p] = 0;
+		mOpenThrees[p] = 0;
+	}
+
+	for (int l = 0; l < cNumLines; ++l)
+	{
+		for (int p = 0; p < 2; ++p)
+			mLineCount[p][l] = popCount(mPieces[p] & cWinningLines[l]);
+
+		for (int p = 0; p < 2; ++p)
+		{
+			mLineValue[p] += lineValue(mLineCount[p][l], mLineCount[p ^ 1][l]);
+			if (mLineCount[p][l] == 3 && mLineCount[p ^ 1][l] == 0)
+				++mOpenThrees[p];
+		}
+	}
+}
+
 /**
  * Convert the board to a human readable string ready to be printed to std::cerr
  *
@@ -212,16 +333,8 @@ std::string GameState::toString(int pPlayer) const
 
 	bool is_winner = (isEOG() && ((pPlayer == CELL_X && isXWin()) || (pPlayer == CELL_O && isOWin())));
 	bool is_my_turn = (mNextPlayer == pPlayer);
-	int X_pieces = 0;
-	int O_pieces = 0;
-	
-	for (int i = 0; i < cSquares; ++i)
-	{
-		if (at(i) & CELL_X)
-			++X_pieces;
-		else if (at(i) & CELL_O)
-			++O_pieces;
-	}
+	int X_pieces = popCount(mPieces[CELL_X - 1]);
+	int O_pieces = popCount(mPieces[CELL_O - 1]);
 
 	// Use a stringstream to compose the string
 	std::stringstream ss;
@@ -250,7 +363,7 @@ std::string GameState::toMessage() const
 
 	// The board goes first
     for(int i=0;i<cSquares;i++)
-		ss << MESSAGE_SYMBOLS[mCell[i]];
+		ss << MESSAGE_SYMBOLS[at(i)];
 
     // Then the information about moves
     assert(mNextPlayer == CELL_O || mNextPlayer == CELL_X);
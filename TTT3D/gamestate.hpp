@@ -3,11 +3,13 @@
 
 #include "constants.hpp"
 #include "move.hpp"
+#include "bitboard.hpp"
 #include <stdint.h>
 #include <cassert>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace TICTACTOE3D
 {
@@ -82,21 +84,15 @@ public:
 	 *   (lBoard.At(10)&CELL_X)
 	 *
 	 */
-	uint8_t& at(int pPos)
+	uint8_t at(int pPos) const
 	{
 		assert(pPos >= 0);
 		assert(pPos < cSquares);
-		return mCell[pPos];
-	}
-
-	/**
-	 * const version of the above function
-	 */
-	const uint8_t& at(int pPos) const
-	{
-		assert(pPos >= 0);
-		assert(pPos < cSquares);
-		return mCell[pPos];
+		if (mPieces[0] & cellBit(pPos))
+			return CELL_X;
+		if (mPieces[1] & cellBit(pPos))
+			return CELL_O;
+		return CELL_EMPTY;
 	}
 
 	/**
@@ -117,17 +113,24 @@ public:
 	{
 		if (pR < 0 || pR > 3 || pC < 0 || pC > 3|| pL < 0 || pL > 3)
 			return CELL_INVALID;
-		return mCell[(pR * 4 + pC)+(16*pL) ];
+		return at((pR * 4 + pC)+(16*pL));
 	}
 
-private:
-	///private version of above function (allows modifying cells)
-	uint8_t &mutableAt(int pR, int pC, int pL) const
+	/**
+	 * Returns the bitboard of the cells owned by \p pPlayer (CELL_X or CELL_O)
+	 *
+	 * Bit i is set if cell i belongs to the player.
+	 */
+	uint64_t getPieces(uint8_t pPlayer) const
+	{
+		assert(pPlayer == CELL_X || pPlayer == CELL_O);
+		return mPieces[pPlayer - 1];
+	}
+
+	///returns the bitboard of the empty cells
+	uint64_t getEmpty() const
 	{
-		//this is a bit ugly, but is useful for the implementation of
-		//findPossibleMoves. It won't affect in single-threaded programs
-		//and you're not allowed to use threads anyway
-		return const_cast<uint8_t&>(mCell[pR * 4 + pC +(16*pL)]);
+		return ~(mPieces[0] | mPieces[1]);
 	}
 
 public:
@@ -173,13 +176,13 @@ private:
 	 * \param pOther the \ref ECell code corresponding to the player
 	 * who is not making the move
 	 */
-	void tryMove(std::vector<Move> &pMoves, int pCell) const;
+	void tryMove(MoveList &pMoves, int pCell) const;
 	
 	
 private:
 	
 	/**
-	* Checks if a move end up being a winning move *
+	* Checks if a move end up being a special move(Winning=1, Draw =2) *
 	* \param pCell the cell where the move is tried
 	* \param pPlayer says who is making the move
 	
@@ -187,106 +190,12 @@ private:
 	
 	int Special_Move(int pCell, Cell pPlayer) const
 	{
-		int lR=cellToRow(pCell)+1;
-		int lC=cellToCol(pCell)+1;
-		int lL=cellToLay(pCell)+1;
-		//check if winning move:
-		int checkWin3D[6][6][6];
-		//fill check 3D array
-		for (int x=0;x<4;x++) {
-			 for (int y=0;y<4;y++) {
-				 for (int z=0;z<4;z++) {
-					 checkWin3D[x+1][y+1][z+1]=at(x,y,z);
-					 }
-				 }
-         } 
-
-		 for (int i=0;i<6;i++) {
-			 for (int j=0;j<6;j++) {
-				 checkWin3D[0][i][j]=7; checkWin3D[5][i][j]=7;
-				 checkWin3D[i][j][0]=7; checkWin3D[i][j][5]=7;
-				 checkWin3D[i][0][j]=7; checkWin3D[i][5][j]=7;}
-		} 
-		
-		 //make the move temporaly:
-		checkWin3D[lR][lC][lL]=pPlayer;
-		
-		int x[4],y[4],z[4];        //variables to store winning coordinates
-		x[0]=lR;y[0]=lC;z[0]=lL;   //sets 0 of each to last move
-     
-		int Pcount;
-     
-     for (int a=1;a<14;a++){    //iterates through all possible directions in 3D space     
-           Pcount=1;                      //reset counter     
-           int lR2=lR; int lC2=lC; int lL2=lL;
-           
-           for (;checkWin3D[lR2][lC2][lL2]!=7;){
-			
-				//look in every derection until out of field ('7')
-                switch (a) {
-					case 1:lR2--;break;                
-					case 2:lR2--;lC2--;lL2--;break;    
-					case 3:lR2--;lC2--;break;          
-					case 4:lR2--;lC2--;lL2++;break;    
-					case 5:lR2--;lL2--;break;          
-					case 6:lR2--;lL2++;break;          
-					case 7:lR2--;lC2++;lL2--;break;    
-					case 8:lR2--;lC2++;break;          
-					case 9:lR2--;lC2++;lL2++;break;    
-					case 10:lL2--;break;               
-					case 11:lC2--;lL2--;break;         
-					case 12:lC2--;break;               
-					case 13:lC2--;lL2++;break;         
-                }                        
-                if (checkWin3D[lR2][lC2][lL2]==pPlayer) {
-                           x[Pcount]=lR2;y[Pcount]=lC2;z[Pcount]=lL2;
-                           Pcount++;}
-                 
-            }                 
-            
-			lR2=lR;lC2=lC;lL2=lL;   //reset placeholder variables
-         
-         
-			for (;checkWin3D[lR2][lC2][lL2]!=7;) { 
-              
-              
-				switch (a) {
-					case 1:lR2++;break;                ///////////////////////
-					case 2:lR2++;lC2++;lL2++;break;      //
-					case 3:lR2++;lC2++;break;           // and
-					case 4:lR2++;lC2++;lL2--;break;      // then back
-					case 5:lR2++;lL2++;break;           //  in the
-					case 6:lR2++;lL2--;break;           //  opposite 
-					case 7:lR2++;lC2--;lL2++;break;      //  direction
-					case 8:lR2++;lC2--;break;           //
-					case 9:lR2++;lC2--;lL2--;break;      //
-					case 10:lL2++;break;               //
-					case 11:lC2++;lL2++;break;          //
-					case 12:lC2++;break;               //
-					case 13:lC2++;lL2--;break;          ///////////////////////
-                }
-                                   
-				if (checkWin3D[lR2][lC2][lL2]==pPlayer) {
-                      x[Pcount]=lR2;y[Pcount]=lC2;z[Pcount]=lL2;
-                      Pcount++;
-                }
-            }
-			   
-            if (Pcount>3) {for (int b=0;b<4;b++) {checkWin3D[x[b]][y[b]][z[b]]=4;} 
-			return 1;}
-        }
-		//Check Draw 
-		int cpieces=0;
-		for (int k = 0; k < cSquares; ++k)
-			{
-				// Try move
-				if(at(k)!=CELL_EMPTY)
-				{
-					cpieces+=1;
-				}
-			}
-			
-		if(cpieces==cSquares-1 )
+		// Only the (at most 7) lines through the cell can be completed by the move
+		if (completesLine(mPieces[pPlayer - 1] | cellBit(pCell), pCell))
+			return 1;
+
+		// Draw if this move fills the last empty cell
+		if (getEmpty() == cellBit(pCell))
 			return 2;
 		
 		return 0;
@@ -302,6 +211,24 @@ public:
 	 */
 	void findPossibleMoves(std::vector<GameState> &pMoves) const;
 
+	/**
+	 * Returns the list of all valid moves in this state
+	 *
+	 * The moves are the same, and in the same order, as the ones leading to
+	 * the states returned by findPossibleMoves, but no state is copied.
+	 *
+	 * \param pMoves the list where the moves will be stored (it is cleared first)
+	 */
+	void generateMoves(MoveList &pMoves) const;
+
+	/**
+	 * Information needed to take back a move performed with doMove
+	 */
+	struct UndoInfo
+	{
+		Move mLastMove;		///< the last move before the move was made
+	};
+
 	/**
 	 * Transforms the board by performing a move
 	 *
@@ -311,22 +238,38 @@ public:
 	 */
 	void doMove(const Move &pMove);
 
+	/**
+	 * Same as above, but also stores in \p pUndo what undoMove needs to restore the state
+	 *
+	 * \param pMove the move to perform
+	 * \param pUndo where the information to undo the move is stored
+	 */
+	void doMove(const Move &pMove, UndoInfo &pUndo)
+	{
+		pUndo.mLastMove = mLastMove;
+		doMove(pMove);
+	}
+
+	/**
+	 * Takes back a move made with doMove(pMove, pUndo)
+	 *
+	 * Moves must be undone in the reverse order they were made.
+	 * \param pMove the move to take back
+	 * \param pUndo the information stored by doMove
+	 */
+	void undoMove(const Move &pMove, const UndoInfo &pUndo);
+
 	/**
 	 * Compares two game states. Return true if game states are identical, otherwise false.
 	 *
 	 * \param gameState game state to compare to
 	 */
-	bool isEqual(GameState gameState)
+	bool isEqual(const GameState &gameState) const
 	{
-		bool equal = true;
-		for (int i = 0; i < cSquares; ++i)
-			if (mCell[i] != gameState.at(i))
-				equal = false;
-		if (mNextPlayer != gameState.getNextPlayer())
-			equal = false;
-		if (mLastMove.toMessage().compare(gameState.getMove().toMessage()) != 0)
-			equal = false;
-		return equal;
+		return mPieces[0] == gameState.mPieces[0]
+			&& mPieces[1] == gameState.mPieces[1]
+			&& mNextPlayer == gameState.mNextPlayer
+			&& mLastMove == gameState.mLastMove;
 	}
 
 	/**
@@ -383,8 +326,70 @@ public:
 		return mLastMove.isDraw();
 	}
 
+	/**
+	 * Returns the value of a line for a player, given how many cells of the line
+	 * the player (\p pOwn) and the opponent (\p pOther) have.
+	 *
+	 * An empty line is worth 1, a line only containing own pieces 2^pOwn, and a
+	 * line blocked by the opponent nothing.
+	 */
+	static int lineValue(int pOwn, int pOther)
+	{
+		if (pOther > 0)
+			return 0;
+		return 1 << pOwn;
+	}
+
+	/**
+	 * Returns the sum of lineValue() over all 76 lines for \p pPlayer (CELL_X or CELL_O)
+	 *
+	 * It is kept up to date by doMove, so reading it costs nothing.
+	 */
+	int getLineValue(uint8_t pPlayer) const
+	{
+		assert(pPlayer == CELL_X || pPlayer == CELL_O);
+		return mLineValue[pPlayer - 1];
+	}
+
+	///returns the number of lines where \p pPlayer has 3 pieces and the opponent none
+	int getOpenThrees(uint8_t pPlayer) const
+	{
+		assert(pPlayer == CELL_X || pPlayer == CELL_O);
+		return mOpenThrees[pPlayer - 1];
+	}
+
+	/**
+	 * Returns the 64-bit Zobrist key of the board
+	 *
+	 * Only the pieces are hashed: they also determine the player to move and
+	 * whether the game has ended. The key is updated by doMove and undoMove.
+	 */
+	uint64_t getHash() const
+	{
+		return mHash;
+	}
+
+private:
+	/**
+	 * Updates the per-line counters after \p pPlayer has been given (\p pDelta = 1)
+	 * or has lost (\p pDelta = -1) cell \p pCell
+	 *
+	 * Only the 4 to 7 lines going through the cell are touched.
+	 */
+	void updateLines(int pCell, uint8_t pPlayer, int pDelta);
+
+	///recomputes all per-line counters from the bitboards
+	void initLines();
+
+	///computes the hash key from scratch
+	uint64_t computeHash() const;
+
 private:
-	uint8_t mCell[cSquares];
+	uint64_t mPieces[2];	///< bitboards of the CELL_X (index 0) and CELL_O (index 1) cells
+	uint8_t mLineCount[2][cNumLines];	///< number of X/O pieces in each winning line
+	int mLineValue[2];	///< sum of lineValue() over all lines, for X and O
+	uint8_t mOpenThrees[2];	///< number of lines with 3 own pieces and no opponent piece, for X and O
+	uint64_t mHash;		///< Zobrist key of the pieces
 	uint8_t mNextPlayer;
 	Move mLastMove;
 };
@@ -1,4 +1,5 @@
 #include "player.hpp"
+#include "minimax.h"
 
 #include <stdlib.h>
 #include <iostream>
@@ -11,6 +12,13 @@ int main(int argc, char **argv)
     bool init = false;
     bool verbose = false;
     bool fast = false;
+    bool ponder = false;
+    int threads = 1;
+    std::string clock_name;
+    std::string book_path;
+    std::string build_book_path;
+    int build_book_plies = 0;
+    double build_book_seconds = 0;
     for (int i = 1; i < argc; ++i)
     {
         std::string param(argv[i]);
@@ -20,6 +28,22 @@ int main(int argc, char **argv)
             verbose = true;
         else if (param == "fast" || param == "f")
             fast = true;
+        else if (param == "ponder" || param == "p")
+            ponder = true;
+        else if ((param == "hash" || param == "h") && i + 1 < argc)
+            TICTACTOE3D::MiniMax::set_hash_size(atoi(argv[++i]));
+        else if ((param == "threads" || param == "t") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if ((param == "clock" || param == "c") && i + 1 < argc && (std::string(argv[i + 1]) == "cpu" || std::string(argv[i + 1]) == "wall"))
+            clock_name = argv[++i];
+        else if ((param == "book" || param == "b") && i + 1 < argc)
+            book_path = argv[++i];
+        else if (param == "build_book" && i + 3 < argc)
+        {
+            build_book_plies = atoi(argv[++i]);
+            build_book_seconds = atof(argv[++i]);
+            build_book_path = argv[++i];
+        }
         else
         {
             std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
@@ -27,6 +51,30 @@ int main(int argc, char **argv)
         }
     }
 
+    TICTACTOE3D::MiniMax::set_threads(threads);
+    TICTACTOE3D::MiniMax::set_verbose(verbose);
+    // CPU time adds up over all threads, so unless told otherwise a threaded
+    // search measures the deadline on the wall clock
+    if (clock_name == "wall" || (clock_name.empty() && threads > 1))
+        TICTACTOE3D::Deadline::useClock(TICTACTOE3D::Deadline::WALL_TIME);
+
+    // Search the openings, write the book and quit if the parameter "build_book" is given
+    if (!build_book_path.empty())
+    {
+        if (build_book_plies > 0 && build_book_seconds > 0
+            && TICTACTOE3D::OpeningBook::generate(build_book_path, build_book_plies, build_book_seconds))
+            return 0;
+        std::cerr << "Cannot build the opening book '" << build_book_path << "'" << std::endl;
+        return -1;
+    }
+
+    TICTACTOE3D::OpeningBook book;
+    if (!book_path.empty() && !book.open(book_path))
+    {
+        std::cerr << "Cannot open the opening book '" << book_path << "'" << std::endl;
+        return -1;
+    }
+
     // Start the game by sending the starting board without moves if the parameter "init" is given
     if (init)
     {
@@ -35,7 +83,7 @@ int main(int argc, char **argv)
         std::cout << message << std::endl;
     }
 
-    TICTACTOE3D::Player player;
+    TICTACTOE3D::Player player(book.isOpen() ? &book : NULL);
 
     std::string input_message;
     while (std::getline(std::cin, input_message))
@@ -103,6 +151,10 @@ int main(int argc, char **argv)
         //std::cerr << "Sending: '" << output_message << "'"<< std::endl;
         std::cout << output_message << std::endl;
 
+        // Think on the opponent's time, while waiting for its move
+        if (ponder && !output_state.getMove().isEOG())
+            TICTACTOE3D::MiniMax::start_pondering(output_state);
+
 		// Quit if this is end of game
         if (output_state.getMove().isEOG())
             break;
@@ -1,31 +1,65 @@
 #ifndef MINIMAX_H
 #define MINIMAX_H
 #include "gamestate.hpp"
-#include "deadline.hpp"
+#include "symmetry.hpp"
+#include "../common/search.hpp"
+#include <climits>
 
 using namespace std;
 namespace TICTACTOE3D
 {
+	using common::Deadline;
+
 	class MiniMax
 	{
-		struct GameStateEvaluation {
-			GameState state;
-			int value;
-
-			bool operator < (const GameStateEvaluation& gse) const
-			{
-				return (value > gse.value);
-			}
-		} typedef GameStateEvaluation;
-
 	public:
 		static GameState get_best_next_state(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type);
+		// The transposition table is kept for the whole game; this sets its size in megabytes
+		static void set_hash_size(size_t megabytes);
+		// Sets the number of threads the root moves are searched on
+		static void set_threads(int threads);
+		// Sets whether the searches log their progress to std::cerr
+		static void set_verbose(bool verbose);
+		// Searches, until the next move is asked for, the position after the reply expected
+		// to our move that led to state
+		static void start_pondering(const GameState& state);
+
+		// The game as seen by the search (see common::Search). Values are from our point
+		// of view, and a won or lost game is worth INT_MAX or -INT_MAX. It is public so that
+		// tools such as the arena can run searches of their own.
+		struct Game
+		{
+			typedef TICTACTOE3D::GameState State;
+			typedef TICTACTOE3D::Move Move;
+			typedef TICTACTOE3D::MoveList MoveList;
+			typedef int Value;
+
+			static int evaluate(const GameState& state, uint8_t our_player_type) { return evaluate_gamestate_3d_2(state, our_player_type); }
+			static bool isDecided(int value) { return value == INT_MAX || value == -INT_MAX; }
+			static bool probe(const GameState&, uint8_t, int&) { return false; }
+			static bool isQuiet(const GameState&) { return true; }
+			static uint64_t key(const GameState& state, int& symmetry) { return transposition_key(state, symmetry); }
+			static int packMove(const MoveList& moves, int index, int symmetry) { return Symmetry::map(symmetry, moves[index][0]); }
+			static int unpackMove(const MoveList& moves, int packed, int symmetry) { return find_move(Symmetry::unmap(symmetry, packed), moves); }
+			static void pruneRootMoves(GameState& state, MoveList& moves) { remove_symmetric_moves(state, moves); }
+			static int maxDepth(const GameState& state) { return popCount(state.getEmpty()); }
+			static int aspirationWindow();
+			static int aspirationLimit();
+			static double timeMargin(int threads);
+			static double iterationGrowth();
+		};
+
 	private:
-		static MiniMax::GameStateEvaluation minimax(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth, int depth);
 		static	int evaluate_gamestate_3d_2(const GameState& game_state, const int our_player_type);
-		static GameStateEvaluation minimax_alpha_beta(const Deadline &pDue, const GameState& current_state, uint8_t our_player_type, const int max_depth, int depth, int alpha, int beta);
-		static void prelim_sort(const Deadline &pDue, uint8_t our_player_type, vector<GameState>& moves);
 		static int evaluate_gamestate_3d(const GameState& game_state, const int our_player_type);
+
+		// Symmetric positions share a key while there are few pieces on the board. Cells
+		// stored in the table are mapped by symmetry, the one that leads to the stored position.
+		static uint64_t transposition_key(const GameState& state, int& symmetry);
+		static void remove_symmetric_moves(GameState& state, MoveList& moves);
+		static int find_move(int cell, const MoveList& moves);
+
+		static common::Search<Game> search;
 	};
 }
 #endif // MINIMAX_H
\ No newline at end of file
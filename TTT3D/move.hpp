@@ -3,7 +3,8 @@
 
 #include "constants.hpp"
 #include <stdint.h>
-#include <vector>
+#include <cstring>
+#include <type_traits>
 #include <string>
 #include <sstream>
 #include <cassert>
@@ -34,12 +35,19 @@ public:
         MOVE_NULL=-5   ///< a null move
     };
 
+    ///the squares of a move: the destination and the player symbol
+    static const int cMaxLength = 2;
+
+    ///the number of move keys, see getKey()
+    static const int cNumKeys = 64;
+
 public:
     ///constructs a special type move
     
     ///\param pType should be one of MOVE_BOG, MOVE_XW, MOVE_OW or MOVE_DRAW
     explicit Move(MoveType pType=MOVE_BOG)
         :   mType(pType)
+        ,   mLength(0)
     {
     }
 
@@ -48,8 +56,8 @@ public:
 	///\param p2 is the player symbol
     Move(uint8_t p1,Cell p2)
         :	mType(MOVE_NORMAL)
+        ,   mLength(2)
     {
-    	mData.resize(2);
     	mData[0] = p1;
 		mData[1] = p2;
     }
@@ -57,9 +65,9 @@ public:
 	///constructs a Special move (Win or Draw) for player
     ///\param p1 the destination square
 	///\param p2 is the player symbol
-    Move(uint8_t p1,Cell p2,int SpecialMove)        
+    Move(uint8_t p1,Cell p2,int SpecialMove)
+        :   mLength(2)
     {
-    	mData.resize(2);
     	mData[0] = p1;
 		mData[1] = p2;
 		if(SpecialMove==2)
@@ -82,6 +90,7 @@ public:
     ///\param pString a string, which should have been previously generated
     ///by ToString(), or obtained from the server
     Move(const std::string &pString)
+        :   mLength(0)
     {
         std::istringstream lStream(pString);        
         lStream >> mType;
@@ -102,13 +111,13 @@ public:
 		if (mType==MOVE_DRAW)
             lLen=2;
             
-        if (lLen>12 || mType<MOVE_NULL)
+        if (lLen>cMaxLength || mType<MOVE_NULL)
         {
             mType=MOVE_NULL;
             return;
         }
             
-        mData.resize(lLen);
+        mLength=lLen;
             
         for (int i=0; i<lLen; ++i)
         {
@@ -143,16 +152,20 @@ public:
     int getType() const { return mType; }
     
     ///returns (for normal moves) the number of squares
-    std::size_t length() const { return mData.size(); }
+    std::size_t length() const { return mLength; }
     ///returns the pNth square in the sequence
     uint8_t operator[](int pN) const { return mData[pN]; }
 
+    ///returns a number below cNumKeys that tells the moves of a position apart
+    ///(used to order moves): the destination square, 0 for special moves
+    int getKey() const { return mLength ? mData[0] : 0; }
+
     ///converts the move to a string so that it can be sent to the other player
     std::string toMessage() const
     {
         std::ostringstream lStream;
         lStream << mType;
-        for(unsigned i=0;i<mData.size();++i)
+        for(unsigned i=0;i<mLength;++i)
         {
             lStream << cDelimiter << (int)mData[i];
         }
@@ -176,11 +189,11 @@ public:
 
         std::ostringstream lStream;
     	char delimiter = isNormal() ? '-' : 'x';
-    	assert(mData.size() > 0);
+    	assert(mLength > 0);
 
     	// Concatenate all the cell numbers
 		lStream << (int)mData[0];
-        for(unsigned i=1; i<mData.size(); ++i)
+        for(unsigned i=1; i<mLength; ++i)
 		{
             lStream << delimiter << (int)mData[i];
 		}
@@ -191,19 +204,69 @@ public:
     bool operator==(const Move &pRH) const
     {
         if (mType != pRH.mType) return false;
-        if (mData.size() != pRH.mData.size()) return false;
-        
-        for (unsigned i=0; i<mData.size(); ++i)
+        if (mLength != pRH.mLength) return false;
+
+        for (unsigned i=0; i<mLength; ++i)
             if (mData[i] != pRH.mData[i]) return false;
         return true;
     }
     
 private:
     int mType;
-    std::vector<uint8_t> mData;
+    uint8_t mLength;
+    uint8_t mData[cMaxLength];
     static const char cDelimiter = '_';
 };
 
+static_assert(std::is_trivially_copyable<Move>::value, "moves are copied around with the MoveList");
+
+/**
+ * A list of moves with a fixed capacity
+ *
+ * It is meant to be declared on the stack of the search, so that generating
+ * the moves of a node does not go through the heap.
+ */
+class MoveList
+{
+public:
+    ///the maximum number of moves from a position (one per cell)
+    static const int cCapacity = 64;
+
+    MoveList()
+        :   mSize(0)
+    {
+    }
+
+    ///appends a move to the list
+    void push_back(const Move &pMove)
+    {
+        assert(mSize < cCapacity);
+        mMoves[mSize++] = pMove;
+    }
+
+    ///removes all moves from the list
+    void clear() { mSize = 0; }
+
+    ///returns the number of moves in the list
+    int size() const { return mSize; }
+    ///returns true if the list contains no moves
+    bool empty() const { return mSize == 0; }
+
+    ///returns the pNth move in the list
+    Move &operator[](int pN) { assert(pN < mSize); return mMoves[pN]; }
+    ///const version of the above function
+    const Move &operator[](int pN) const { assert(pN < mSize); return mMoves[pN]; }
+
+    Move *begin() { return mMoves; }
+    Move *end() { return mMoves + mSize; }
+    const Move *begin() const { return mMoves; }
+    const Move *end() const { return mMoves + mSize; }
+
+private:
+    Move mMoves[cCapacity];
+    int mSize;
+};
+
 /*namespace TICTACTOE3D*/ }
 
 #endif
@@ -0,0 +1,130 @@
+#include "opening_book.hpp"
+#include "symmetry.hpp"
+#include "minimax.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace TICTACTOE3D
+{
+
+const char OpeningBook::cMagic[8] = { 'T', 'T', 'T', '3', 'B', 'O', 'O', 'K' };
+
+bool OpeningBook::generate(const std::string &pPath, int pPlies, double pSeconds)
+{
+	Deadline lStart = Deadline::now();
+
+	// The positions of each ply, one of each class of symmetric positions, from
+	// the moves of those of the ply before
+	std::map<uint64_t, GameState> lPositions;
+	std::vector<GameState> lPly(1, GameState());
+	for (int lPieces = 0; lPieces < pPlies && !lPly.empty(); ++lPieces)
+	{
+		std::vector<GameState> lNextPly;
+		for (size_t i = 0; i < lPly.size(); ++i)
+		{
+			int lSymmetry;
+			uint64_t lKey = Symmetry::canonicalKey(lPly[i].getPieces(CELL_X), lPly[i].getPieces(CELL_O), lSymmetry);
+			if (lPly[i].isEOG() || !lPositions.insert(std::make_pair(lKey, lPly[i])).second || lPieces + 1 == pPlies)
+				continue;
+
+			MoveList lMoves;
+			lPly[i].generateMoves(lMoves);
+			for (int m = 0; m < lMoves.size(); ++m)
+				lNextPly.push_back(GameState(lPly[i], lMoves[m]));
+		}
+		lPly.swap(lNextPly);
+	}
+	std::cerr << "book:" << lPositions.size() << " positions:estimated time:" << lPositions.size() * pSeconds << std::endl;
+
+	// The search keeps its transposition table from one position to the next,
+	// so the later ones start from what the earlier ones found
+	std::vector<uint64_t> lEntries;
+	for (std::map<uint64_t, GameState>::const_iterator it = lPositions.begin(); it != lPositions.end(); ++it)
+	{
+		const GameState &lState = it->second;
+		uint8_t lPlayer = lState.getNextPlayer() ^ (CELL_X | CELL_O);
+		GameState lNext = MiniMax::get_best_next_state(Deadline::now() + pSeconds, lState, lPlayer);
+
+		// The cell is stored on the canonical board, so that it applies to every
+		// position with the same key
+		int lSymmetry;
+		Symmetry::canonicalKey(lState.getPieces(CELL_X), lState.getPieces(CELL_O), lSymmetry);
+		lEntries.push_back((it->first & ~cCellMask) | (uint64_t)Symmetry::map(lSymmetry, lNext.getMove()[0]));
+	}
+	std::sort(lEntries.begin(), lEntries.end());
+
+	Header lHeader;
+	std::memset(&lHeader, 0, sizeof(lHeader));
+	std::memcpy(lHeader.mMagic, cMagic, sizeof(cMagic));
+	lHeader.mVersion = cVersion;
+	lHeader.mPlies = (uint32_t)pPlies;
+	lHeader.mCount = (uint32_t)lEntries.size();
+
+	std::ofstream lFile(pPath.c_str(), std::ios::binary | std::ios::trunc);
+	lFile.write(reinterpret_cast<const char*>(&lHeader), sizeof(lHeader));
+	if (!lEntries.empty())
+		lFile.write(reinterpret_cast<const char*>(&lEntries[0]), lEntries.size() * sizeof(uint64_t));
+	lFile.close();
+	if (!lFile)
+		return false;
+
+	std::cerr << "book:" << lEntries.size() << " entries:time:" << Deadline::now() - lStart << std::endl;
+	return true;
+}
+
+bool OpeningBook::open(const std::string &pPath)
+{
+	mEntries = NULL;
+	mCount = 0;
+	if (!mFile.open(pPath))
+		return false;
+
+	Header lHeader;
+	if (mFile.size() < sizeof(lHeader))
+		return false;
+	std::memcpy(&lHeader, mFile.data(), sizeof(lHeader));
+	if (std::memcmp(lHeader.mMagic, cMagic, sizeof(cMagic)) != 0 || lHeader.mVersion != cVersion
+		|| lHeader.mCount == 0 || mFile.size() != sizeof(lHeader) + (std::size_t)lHeader.mCount * sizeof(uint64_t))
+	{
+		mFile.close();
+		return false;
+	}
+
+	mEntries = reinterpret_cast<const uint64_t*>(mFile.data() + sizeof(lHeader));
+	mCount = lHeader.mCount;
+	return true;
+}
+
+bool OpeningBook::probe(const GameState &pState, Move &pMove) const
+{
+	if (!mEntries || pState.isEOG())
+		return false;
+
+	// The entries of a key are the only ones between the key with the cell bits
+	// cleared and with them set
+	int lSymmetry;
+	uint64_t lKey = Symmetry::canonicalKey(pState.getPieces(CELL_X), pState.getPieces(CELL_O), lSymmetry) & ~cCellMask;
+	const uint64_t *lEntry = std::lower_bound(mEntries, mEntries + mCount, lKey);
+	if (lEntry == mEntries + mCount || (*lEntry & ~cCellMask) != lKey)
+		return false;
+
+	// Take the move back from the canonical board to this one
+	int lCell = Symmetry::unmap(lSymmetry, (int)(*lEntry & cCellMask));
+	MoveList lMoves;
+	pState.generateMoves(lMoves);
+	for (int i = 0; i < lMoves.size(); ++i)
+	{
+		if (lMoves[i][0] == lCell)
+		{
+			pMove = lMoves[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+/*namespace TICTACTOE3D*/ }
@@ -0,0 +1,69 @@
+#ifndef _TICTACTOE3D_OPENING_BOOK_HPP_
+#define _TICTACTOE3D_OPENING_BOOK_HPP_
+
+#include "gamestate.hpp"
+#include "../common/mapped_file.hpp"
+#include <stdint.h>
+#include <string>
+
+namespace TICTACTOE3D {
+
+/**
+ * The moves to play in the first plies of the game, found by long searches
+ *
+ * generate() searches every position of the first plies, with symmetric
+ * positions (see Symmetry) searched once, for as long as it is told to, and
+ * writes the move the search chose. open() maps such a file, and probe() looks
+ * a position up in it.
+ *
+ * The file is a Header followed by the entries, sorted, so a probe is a binary
+ * search. An entry is a single 64-bit word: the canonical key of the position
+ * with its lowest 6 bits replaced by the cell to play on the canonical board.
+ * Numbers are stored in the byte order of the machine that generated the file.
+ */
+class OpeningBook
+{
+public:
+    OpeningBook()
+        :   mEntries(NULL)
+        ,   mCount(0)
+    {
+    }
+
+    ///searches every position with fewer than \p pPlies pieces for \p pSeconds
+    ///and writes the book to \p pPath, returns false if the file cannot be written
+    static bool generate(const std::string &pPath, int pPlies, double pSeconds);
+
+    ///maps the book at \p pPath, returns false if it is missing or invalid
+    bool open(const std::string &pPath);
+
+    ///returns true while a book is mapped
+    bool isOpen() const    {    return mEntries != NULL;    }
+
+    ///looks up \p pState and sets \p pMove to the move to play, returns false
+    ///if the position is not in the book
+    bool probe(const GameState &pState, Move &pMove) const;
+
+private:
+    struct Header
+    {
+        char mMagic[8];         ///< cMagic
+        uint32_t mVersion;      ///< cVersion
+        uint32_t mPlies;        ///< the positions have fewer pieces than this
+        uint32_t mCount;        ///< the number of entries
+        uint32_t mReserved;
+    };
+
+    static const char cMagic[8];
+    static const uint32_t cVersion = 1;
+    ///the bits of an entry that hold the cell
+    static const uint64_t cCellMask = 63;
+
+    common::MappedFile mFile;
+    const uint64_t *mEntries;
+    uint32_t mCount;
+};
+
+/*namespace TICTACTOE3D*/ }
+
+#endif
@@ -20,6 +20,15 @@ namespace TICTACTOE3D
 		 * Here you should write your clever algorithms to get the best next move, ie the best
 		 * next state. This skeleton returns a random move instead.
 		 */
+
+		// The opening moves were searched long before the game
+		Move book_move;
+		if (mBook && mBook->probe(pState, book_move))
+		{
+			cerr << "book:" << (int)book_move[0] << endl;
+			return GameState(pState, book_move);
+		}
+
 		GameState best_move = MiniMax::get_best_next_state(pDue, pState, pState.getNextPlayer() ^ (CELL_X | CELL_O));
 
 		//assert(pState.getNextPlayer() != best_move.getNextPlayer());
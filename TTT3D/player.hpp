@@ -2,22 +2,34 @@
 #define _TICTACTOE3D_PLAYER_HPP_
 
 #include "constants.hpp"
-#include "deadline.hpp"
+#include "../common/deadline.hpp"
 #include "move.hpp"
 #include "gamestate.hpp"
+#include "opening_book.hpp"
 #include <vector>
 
 namespace TICTACTOE3D
 {
 
+using common::Deadline;
+
 class Player
 {
 public:
+    ///\param pBook the moves to play in the opening, or NULL to search every move
+    explicit Player(const OpeningBook *pBook = NULL)
+        :   mBook(pBook)
+    {
+    }
+
     ///perform a move
     ///\param pState the current state of the board
     ///\param pDue time before which we must have returned
     ///\return the next state the board is in after our move
     GameState play(const GameState &pState, const Deadline &pDue);
+
+private:
+    const OpeningBook *mBook;
 };
 
 /*namespace TICTACTOE3D*/ }
@@ -3,7 +3,7 @@
 # javac HelloWorld.java; 
 # java Helloworld;
 
-if g++ *.cpp -Wall -std=c++11 -stdlib=libc++ -o TTT.exe;
+if g++ *.cpp -Wall -std=c++11 -pthread -stdlib=libc++ -o TTT.exe;
 then
    echo "Compilation successful!"
     ./TTT.exe init verbose < pipe | ./TTT.exe verbose > pipe
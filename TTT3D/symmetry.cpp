@@ -0,0 +1,106 @@
+#include "symmetry.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TICTACTOE3D
+{
+
+const Symmetry::Tables Symmetry::sTables;
+
+/**
+ * Finds the symmetries by brute force
+ *
+ * A cell is (column, row, layer), each coordinate from 0 to 3. Every candidate
+ * permutes the three axes and then relabels each coordinate with a bijection
+ * of {0, 1, 2, 3}; the ones that map all winning lines to winning lines are
+ * kept. Candidates are enumerated starting from the identity.
+ */
+Symmetry::Tables::Tables()
+{
+	uint64_t lLines[cNumLines];
+	std::copy(cWinningLines, cWinningLines + cNumLines, lLines);
+	std::sort(lLines, lLines + cNumLines);
+
+	int lAxes[3] = { 0, 1, 2 };
+	int lCount = 0;
+	do
+	{
+		int lX[4] = { 0, 1, 2, 3 };
+		do
+		{
+			int lY[4] = { 0, 1, 2, 3 };
+			do
+			{
+				int lZ[4] = { 0, 1, 2, 3 };
+				do
+				{
+					const int *lRelabel[3] = { lX, lY, lZ };
+					uint8_t lMap[64];
+					for (int lCell = 0; lCell < 64; ++lCell)
+					{
+						int lFrom[3] = { lCell & 3, (lCell >> 2) & 3, lCell >> 4 };
+						int lTo[3];
+						for (int a = 0; a < 3; ++a)
+							lTo[a] = lRelabel[a][lFrom[lAxes[a]]];
+						lMap[lCell] = (uint8_t)(lTo[0] + 4 * lTo[1] + 16 * lTo[2]);
+					}
+
+					// Axis-parallel lines are always preserved, so start from the diagonals
+					bool lPreserves = true;
+					for (int i = cNumLines - 1; i >= 0 && lPreserves; --i)
+					{
+						uint64_t lMapped = 0;
+						for (uint64_t lCells = cWinningLines[i]; lCells; lCells &= lCells - 1)
+							lMapped |= cellBit(lMap[lowestBit(lCells)]);
+						lPreserves = std::binary_search(lLines, lLines + cNumLines, lMapped);
+					}
+
+					if (lPreserves)
+					{
+						assert(lCount < cNumSymmetries);
+						for (int lCell = 0; lCell < 64; ++lCell)
+						{
+							mMap[lCount][lCell] = lMap[lCell];
+							mUnmap[lCount][lMap[lCell]] = (uint8_t)lCell;
+						}
+						++lCount;
+					}
+				} while (std::next_permutation(lZ, lZ + 4));
+			} while (std::next_permutation(lY, lY + 4));
+		} while (std::next_permutation(lX, lX + 4));
+	} while (std::next_permutation(lAxes, lAxes + 3));
+
+	assert(lCount == cNumSymmetries);
+}
+
+///mixes the bits of \p pValue (the splitmix64 finalizer)
+static inline uint64_t mix(uint64_t pValue)
+{
+	pValue = (pValue ^ (pValue >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	pValue = (pValue ^ (pValue >> 27)) * 0x94d049bb133111ebULL;
+	return pValue ^ (pValue >> 31);
+}
+
+uint64_t Symmetry::canonicalKey(uint64_t pX, uint64_t pO, int &pSymmetry)
+{
+	uint64_t lBestX = pX;
+	uint64_t lBestO = pO;
+	pSymmetry = 0;
+	for (int s = 1; s < cNumSymmetries; ++s)
+	{
+		uint64_t lX = mapBoard(s, pX);
+		if (lX > lBestX)
+			continue;
+		uint64_t lO = mapBoard(s, pO);
+		if (lX < lBestX || lO < lBestO)
+		{
+			lBestX = lX;
+			lBestO = lO;
+			pSymmetry = s;
+		}
+	}
+	return mix(lBestX ^ mix(lBestO + 0x9e3779b97f4a7c15ULL));
+}
+
+/*namespace TICTACTOE3D*/ }
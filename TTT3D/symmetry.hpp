@@ -0,0 +1,69 @@
+#ifndef _TICTACTOE3D_SYMMETRY_HPP_
+#define _TICTACTOE3D_SYMMETRY_HPP_
+
+#include "bitboard.hpp"
+#include <stdint.h>
+
+namespace TICTACTOE3D {
+
+/**
+ * The symmetries of the 4x4x4 cube
+ *
+ * These are the 192 permutations of the cells that map every winning line to
+ * a winning line: the 48 rotations and reflections of the cube, each combined
+ * with the 4 maps that swap inner and outer coordinates. Symmetric positions
+ * have the same value, so the search can share transposition table entries
+ * between them and only try one move of each class of equivalent moves.
+ *
+ * Symmetry 0 is the identity.
+ */
+class Symmetry
+{
+public:
+    static const int cNumSymmetries = 192;
+
+    ///canonical keys are only worth their cost while there are few pieces
+    ///on the board: later on, symmetric transpositions are rare
+    static const int cMaxCanonicalPieces = 16;
+
+    ///returns the cell that symmetry \p pSymmetry maps \p pCell to
+    static int map(int pSymmetry, int pCell)        {    return sTables.mMap[pSymmetry][pCell];    }
+
+    ///returns the cell that symmetry \p pSymmetry maps to \p pCell
+    static int unmap(int pSymmetry, int pCell)      {    return sTables.mUnmap[pSymmetry][pCell];    }
+
+    ///returns the bitboard \p pBoard transformed by symmetry \p pSymmetry
+    static uint64_t mapBoard(int pSymmetry, uint64_t pBoard)
+    {
+        uint64_t lResult = 0;
+        for (; pBoard; pBoard &= pBoard - 1)
+            lResult |= cellBit(sTables.mMap[pSymmetry][lowestBit(pBoard)]);
+        return lResult;
+    }
+
+    /**
+     * Returns a key which is the same for all symmetric positions
+     *
+     * The position with bitboards \p pX and \p pO is transformed by every
+     * symmetry and the smallest (X, O) pair is hashed.
+     *
+     * \param pSymmetry is set to the symmetry that maps the position to the
+     * one that was hashed
+     */
+    static uint64_t canonicalKey(uint64_t pX, uint64_t pO, int &pSymmetry);
+
+private:
+    struct Tables
+    {
+        Tables();
+
+        uint8_t mMap[cNumSymmetries][64];
+        uint8_t mUnmap[cNumSymmetries][64];
+    };
+
+    static const Tables sTables;
+};
+
+/*namespace TICTACTOE3D*/ }
+
+#endif
@@ -7,22 +7,34 @@
 // Windows
 #ifdef _WIN32
 #include <Windows.h>
-static inline double get_cpu_time() {
+static inline int64_t get_cpu_time() {
     FILETIME a,b,c,d;
     if (GetProcessTimes(GetCurrentProcess(),&a,&b,&c,&d) != 0){
-        return (double)(d.dwLowDateTime |
-            ((unsigned long long)d.dwHighDateTime << 32)) * 0.0000001;
+        return (int64_t)(d.dwLowDateTime |
+            ((unsigned long long)d.dwHighDateTime << 32)) * 100;
     } else {
         return 0;
     }
 }
+static inline int64_t get_wall_time() {
+    LARGE_INTEGER lCount, lFrequency;
+    QueryPerformanceCounter(&lCount);
+    QueryPerformanceFrequency(&lFrequency);
+    return lCount.QuadPart / lFrequency.QuadPart * 1000000000 +
+        lCount.QuadPart % lFrequency.QuadPart * 1000000000 / lFrequency.QuadPart;
+}
 
 // Posix/Linux
 #else
 #include <time.h>
 #include <sys/time.h>
-static inline double get_cpu_time() {
-    return (double)clock() / CLOCKS_PER_SEC;
+static inline int64_t get_cpu_time() {
+    return (int64_t)clock() * 1000000000 / CLOCKS_PER_SEC;
+}
+static inline int64_t get_wall_time() {
+    struct timespec lTime;
+    clock_gettime(CLOCK_MONOTONIC, &lTime);
+    return (int64_t)lTime.tv_sec * 1000000000 + lTime.tv_nsec;
 }
 #endif
 
@@ -32,8 +44,15 @@ namespace checkers {
 class Deadline
 {
 public:
-    ///initializes the time to \p pTime (in microseconds since the epoch)
-    explicit Deadline(double pTime=-1)
+    ///the clocks a time can be read from
+    enum EClock
+    {
+        CPU_TIME,      ///< CPU time of the process
+        WALL_TIME      ///< monotonic wall-clock time
+    };
+
+    ///initializes the time to \p pTime (in nanoseconds on the clock in use)
+    explicit Deadline(int64_t pTime=-1)
         :   mTime(pTime)
     {
     }
@@ -44,14 +63,14 @@ public:
     ///converts the time to a struct timeval
     void toTimeval(struct timeval &pTime) const
     {
-        pTime.tv_sec=((long)(mTime * 1e6))/1000000;
-        pTime.tv_usec=((long)(mTime * 1e6))%1000000;
+        pTime.tv_sec=(long)(mTime/1000000000);
+        pTime.tv_usec=(long)(mTime%1000000000/1000);
     }
 
     ///converts the time from this time to \p pUntil to a struct timeval
     void toTimevalUntil(const Deadline &pUntil,struct timeval &pDiff) const
     {
-        long lDiff=(long)(pUntil.mTime-mTime * 1e6);
+        int64_t lDiff=pUntil.mTime-mTime;
         if(lDiff<=0)
         {
             pDiff.tv_sec=0;
@@ -59,19 +78,35 @@ public:
         }
         else
         {
-            pDiff.tv_sec=lDiff/1000000;
-            pDiff.tv_usec=lDiff%1000000;
+            pDiff.tv_sec=(long)(lDiff/1000000000);
+            pDiff.tv_usec=(long)(lDiff%1000000000/1000);
         }
     }
 
-    //Returns a Deadline object representing the CPU time in seconds.
+    //Returns a Deadline object representing the current time on the clock
+    //selected by useClock(), the CPU time by default.
     static Deadline now()
     {
-        return Deadline(get_cpu_time());
+        return Deadline(selectedClock()==WALL_TIME ? get_wall_time() : get_cpu_time());
     }
 
+    ///selects the clock read by now(). Call it at startup, before any time is
+    ///taken: times read from different clocks cannot be compared. The CPU time
+    ///runs faster than real time once several threads search, and stops while
+    ///the process waits for input.
+    static void useClock(EClock pClock)
+    {
+        selectedClock() = pClock;
+    }
+
+    ///returns the clock read by now()
+    static EClock getClock()    {    return selectedClock();    }
+
     //Returns the value of this deadline in seconds.
-    double getSeconds() const    {    return mTime;    }
+    double getSeconds() const    {    return mTime*1e-9;    }
+
+    //Returns the value of this deadline in nanoseconds.
+    int64_t getNanoseconds() const    {    return mTime;    }
 
     ///comparison operator
     bool operator<(const Deadline &pOther) const
@@ -112,24 +147,97 @@ public:
     ///adds a delta (in seconds) to this deadline object
     Deadline operator+(double pDelta) const
     {
-        return Deadline(mTime+pDelta);
+        return Deadline(mTime+(int64_t)(pDelta*1e9));
     }
 
     ///subtracts a delta (in seconds) from this deadline object
     Deadline operator-(double pDelta) const
     {
-        return Deadline(mTime-pDelta);
+        return Deadline(mTime-(int64_t)(pDelta*1e9));
     }
 
-    ///Subtracts one deadline object from another, returning the 
+    ///Subtracts one deadline object from another, returning the
     ///difference in seconds.
     double operator-(const Deadline &pRH) const
     {
-        return mTime-pRH.mTime;
+        return (mTime-pRH.mTime)*1e-9;
+    }
+
+private:
+    static EClock &selectedClock()
+    {
+        static EClock sClock = CPU_TIME;
+        return sClock;
+    }
+
+    int64_t mTime;
+};
+
+/**
+ * Checks a deadline only every few calls
+ *
+ * Reading the clock costs more than a search node, so a search calls expired()
+ * at every node and the clock is only read every getInterval() calls. The
+ * interval is tuned from the measured rate of calls so that the clock is read
+ * about every cPollPeriod nanoseconds, within [cMinInterval, cMaxInterval].
+ * Once the time is up expired() keeps returning true without reading the
+ * clock again.
+ *
+ * A DeadlinePoll is meant to be used by a single thread.
+ */
+class DeadlinePoll
+{
+public:
+    static const unsigned cMinInterval = 1024;
+    static const unsigned cMaxInterval = 4096;
+    static const int64_t cPollPeriod = 1000000;
+
+    ///polls for the time \p pMargin seconds before \p pDue
+    explicit DeadlinePoll(const Deadline &pDue, double pMargin = 0)
+        :   mLimit(pDue - pMargin)
+        ,   mLastCheck(Deadline::now())
+        ,   mInterval(cMinInterval)
+        ,   mCount(0)
+        ,   mExpired(false)
+    {
+    }
+
+    ///returns true once the time is up, reading the clock every getInterval() calls
+    bool expired()
+    {
+        if (mExpired)
+            return true;
+        if (++mCount < mInterval)
+            return false;
+        return expiredNow();
     }
 
+    ///reads the clock now, whatever the call count
+    bool expiredNow()
+    {
+        Deadline lNow = Deadline::now();
+        mExpired = mExpired || lNow >= mLimit;
+
+        int64_t lElapsed = lNow.getNanoseconds() - mLastCheck.getNanoseconds();
+        if (lElapsed > 0)
+        {
+            int64_t lInterval = mCount * cPollPeriod / lElapsed;
+            mInterval = lInterval < cMinInterval ? cMinInterval : lInterval > cMaxInterval ? cMaxInterval : (unsigned)lInterval;
+        }
+        mLastCheck = lNow;
+        mCount = 0;
+        return mExpired;
+    }
+
+    ///returns the number of calls to expired() between two readings of the clock
+    unsigned getInterval() const    {    return mInterval;    }
+
 private:
-    double mTime;
+    Deadline mLimit;
+    Deadline mLastCheck;
+    unsigned mInterval;
+    unsigned mCount;
+    bool mExpired;
 };
 
 /*namespace checkers*/ }
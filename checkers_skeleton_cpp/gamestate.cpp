@@ -138,7 +138,7 @@ GameState GameState::reversed() const
  * inserted (for multiple jumps)
  * \param pDepth the number of multiple jumps before this attempt
  */
-bool GameState::tryJump(std::vector<Move> &pMoves, int pR, int pC,
+bool GameState::tryJump(MoveList &pMoves, int pR, int pC,
              bool pKing, uint8_t *pBuffer, int pDepth) const
 {
     // Remove ourself temporarily
@@ -213,7 +213,7 @@ bool GameState::tryJump(std::vector<Move> &pMoves, int pR, int pC,
  * who is not making the move
  * \param pKing true if the piece is a king
  */
-void GameState::tryMove(std::vector<Move> &pMoves, int pCell, bool pKing) const
+void GameState::tryMove(MoveList &pMoves, int pCell, bool pKing) const
 {
     int lR=cellToRow(pCell);
     int lC=cellToCol(pCell);
@@ -263,7 +263,7 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
     bool lFound=false;
     int lPieces[cPlayerPieces];
     uint8_t lMoveBuffer[cPlayerPieces];
-	std::vector<Move> lMoves;
+	MoveList lMoves;
     int lNumPieces=0;
     for (int i = 0; i < cSquares; ++i)
     {
@@ -291,7 +291,7 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
     }
 
     // Convert moves to GameStates
-    for (unsigned i = 0; i < lMoves.size(); ++i)
+    for (int i = 0; i < lMoves.size(); ++i)
     	pStates.push_back(GameState(*this, lMoves[i]));
 
     // Admit loss if no moves can be found
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace checkers
 {
@@ -194,7 +195,7 @@ private:
 	 * inserted (for multiple jumps)
 	 * \param pDepth the number of multiple jumps before this attempt
 	 */
-	bool tryJump(std::vector<Move> &pMoves, int pR, int pC, bool pKing,
+	bool tryJump(MoveList &pMoves, int pR, int pC, bool pKing,
 			uint8_t *pBuffer, int pDepth = 0) const;
 
 	/**
@@ -206,7 +207,7 @@ private:
 	 * who is not making the move
 	 * \param pKing true if the piece is a king
 	 */
-	void tryMove(std::vector<Move> &pMoves, int pCell, bool pKing) const;
+	void tryMove(MoveList &pMoves, int pCell, bool pKing) const;
 
 public:
 	/**
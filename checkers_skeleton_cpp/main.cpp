@@ -10,6 +10,7 @@ int main(int argc, char **argv)
     bool init = false;
     bool verbose = false;
     bool fast = false;
+    std::string clock_name;
     for (int i = 1; i < argc; ++i)
     {
         std::string param(argv[i]);
@@ -19,6 +20,8 @@ int main(int argc, char **argv)
             verbose = true;
         else if (param == "fast" || param == "f")
             fast = true;
+        else if ((param == "clock" || param == "c") && i + 1 < argc && (std::string(argv[i + 1]) == "cpu" || std::string(argv[i + 1]) == "wall"))
+            clock_name = argv[++i];
         else
         {
             std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
@@ -26,6 +29,9 @@ int main(int argc, char **argv)
         }
     }
 
+    if (clock_name == "wall")
+        checkers::Deadline::useClock(checkers::Deadline::WALL_TIME);
+
     // Start the game by sending the starting board without moves if the parameter "init" is given
     if (init)
     {
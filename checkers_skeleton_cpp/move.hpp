@@ -3,7 +3,8 @@
 
 #include "constants.hpp"
 #include <stdint.h>
-#include <vector>
+#include <cstring>
+#include <type_traits>
 #include <string>
 #include <sstream>
 #include <cassert>
@@ -34,12 +35,17 @@ public:
         MOVE_NULL=-5   ///< a null move
     };
 
+    ///the longest sequence of squares in a move: a jump over every piece of the
+    ///other player
+    static const int cMaxLength = 12;
+
 public:
     ///constructs a special type move
     
     ///\param pType should be one of MOVE_BOG, MOVE_RW, MOVE_WW or MOVE_DRAW
     explicit Move(MoveType pType=MOVE_BOG)
         :   mType(pType)
+        ,   mLength(0)
     {
     }
 
@@ -49,8 +55,8 @@ public:
     ///\param p2 the destination square
     Move(uint8_t p1,uint8_t p2)
         :	mType(MOVE_NORMAL)
+        ,   mLength(2)
     {
-    	mData.resize(2);
     	mData[0] = p1;
     	mData[1] = p2;
     }
@@ -61,8 +67,10 @@ public:
     ///\param pLen the number of squares in pData
     Move(uint8_t *pData,std::size_t pLen)
         :	mType(pLen-1)
-        ,   mData(pData, pData + pLen)
+        ,   mLength((uint8_t)pLen)
     {
+        assert(pLen <= (std::size_t)cMaxLength);
+        std::memcpy(mData, pData, pLen);
     }
     
     ///reconstructs the move from a string
@@ -70,6 +78,7 @@ public:
     ///\param pString a string, which should have been previously generated
     ///by ToString(), or obtained from the server
     Move(const std::string &pString)
+        :   mLength(0)
     {
         std::istringstream lStream(pString);
         
@@ -82,13 +91,13 @@ public:
         else if(mType>0)
             lLen = mType+1;
             
-        if (lLen>12 || mType<MOVE_NULL)
+        if (lLen>cMaxLength || mType<MOVE_NULL)
         {
             mType=MOVE_NULL;
             return;
         }
             
-        mData.resize(lLen);
+        mLength=lLen;
             
         for (int i=0; i<lLen; ++i)
         {
@@ -116,7 +125,7 @@ public:
     	else if (isWhiteWin())
     		result.mType = MOVE_RW;
 
-    	for (unsigned i=0; i < mData.size(); ++i)
+    	for (unsigned i=0; i < mLength; ++i)
 			result.mData[i] = 31 - mData[i];
 
     	return result;
@@ -143,7 +152,7 @@ public:
     int getType() const { return mType; }
     
     ///returns (for normal moves and jumps) the number of squares
-    std::size_t length() const { return mData.size(); }
+    std::size_t length() const { return mLength; }
     ///returns the pNth square in the sequence
     uint8_t operator[](int pN) const { return mData[pN]; }
 
@@ -152,7 +161,7 @@ public:
     {
         std::ostringstream lStream;
         lStream << mType;
-        for(unsigned i=0;i<mData.size();++i)
+        for(unsigned i=0;i<mLength;++i)
         {
             lStream << cDelimiter << (int)mData[i];
         }
@@ -176,11 +185,11 @@ public:
 
         std::ostringstream lStream;
     	char delimiter = isNormal() ? '-' : 'x';
-    	assert(mData.size() > 0);
+    	assert(mLength > 0);
 
     	// Concatenate all the cell numbers
 		lStream << (int)mData[0];
-        for(unsigned i=1; i<mData.size(); ++i)
+        for(unsigned i=1; i<mLength; ++i)
             lStream << delimiter << (int)mData[i];
 
         return lStream.str();
@@ -190,19 +199,71 @@ public:
     bool operator==(const Move &pRH) const
     {
         if (mType != pRH.mType) return false;
-        if (mData.size() != pRH.mData.size()) return false;
-        
-        for (unsigned i=0; i<mData.size(); ++i)
+        if (mLength != pRH.mLength) return false;
+
+        for (unsigned i=0; i<mLength; ++i)
             if (mData[i] != pRH.mData[i]) return false;
         return true;
     }
     
 private:
     int mType;
-    std::vector<uint8_t> mData;
+    uint8_t mLength;
+    uint8_t mData[cMaxLength];
     static const char cDelimiter = '_';
 };
 
+static_assert(std::is_trivially_copyable<Move>::value, "moves are copied around with the MoveList");
+
+/**
+ * A list of moves with a fixed capacity
+ *
+ * It is meant to be declared on the stack of the search, so that generating
+ * the moves of a node does not go through the heap.
+ */
+class MoveList
+{
+public:
+    ///the maximum number of moves from a position (12 kings have at most 48
+    ///normal moves, and positions with more jump sequences than this do not
+    ///occur in play)
+    static const int cCapacity = 128;
+
+    MoveList()
+        :   mSize(0)
+    {
+    }
+
+    ///appends a move to the list
+    void push_back(const Move &pMove)
+    {
+        assert(mSize < cCapacity);
+        mMoves[mSize++] = pMove;
+    }
+
+    ///removes all moves from the list
+    void clear() { mSize = 0; }
+
+    ///returns the number of moves in the list
+    int size() const { return mSize; }
+    ///returns true if the list contains no moves
+    bool empty() const { return mSize == 0; }
+
+    ///returns the pNth move in the list
+    Move &operator[](int pN) { assert(pN < mSize); return mMoves[pN]; }
+    ///const version of the above function
+    const Move &operator[](int pN) const { assert(pN < mSize); return mMoves[pN]; }
+
+    Move *begin() { return mMoves; }
+    Move *end() { return mMoves + mSize; }
+    const Move *begin() const { return mMoves; }
+    const Move *end() const { return mMoves + mSize; }
+
+private:
+    Move mMoves[cCapacity];
+    int mSize;
+};
+
 /*namespace checkers*/ }
 
 #endif
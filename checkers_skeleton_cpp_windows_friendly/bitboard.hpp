@@ -0,0 +1,94 @@
+#ifndef _CHECKERS_BITBOARD_HPP_
+#define _CHECKERS_BITBOARD_HPP_
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace checkers {
+
+/**
+ * Bitboard helpers for the 32 playable squares
+ *
+ * A set of squares is stored in a uint32_t, where bit i is set for cell i (see
+ * GameState for the cell numbering). Each row holds four cells, and the cells
+ * of even rows sit one column to the right of those of odd rows, so a step
+ * along a diagonal adds or subtracts 3, 4 or 5 to the cell index depending on
+ * the direction and on the parity of the row. shift() moves a whole set of
+ * squares one step at once, dropping the squares that would leave the board.
+ */
+
+///the four diagonal directions, in the order moves are generated
+enum EDirection
+{
+	DOWN_LEFT,		///< towards row 7 and column 0
+	DOWN_RIGHT,		///< towards row 7 and column 7
+	UP_LEFT,		///< towards row 0 and column 0
+	UP_RIGHT,		///< towards row 0 and column 7
+	NUM_DIRECTIONS
+};
+
+///the cells of the even rows (0, 2, 4, 6)
+static const uint32_t cEvenRows = 0x0f0f0f0fU;
+///the cells of the odd rows (1, 3, 5, 7)
+static const uint32_t cOddRows = 0xf0f0f0f0U;
+///the cells in column 0
+static const uint32_t cLeftEdge = 0x10101010U;
+///the cells in column 7
+static const uint32_t cRightEdge = 0x08080808U;
+
+///returns the direction opposite to \p pDirection
+inline int opposite(int pDirection)
+{
+	return UP_RIGHT - pDirection;
+}
+
+///returns the squares one diagonal step from \p pSquares in direction \p pDirection
+inline uint32_t shift(uint32_t pSquares, int pDirection)
+{
+	switch (pDirection)
+	{
+	case DOWN_LEFT:
+		return ((pSquares & cOddRows & ~cLeftEdge) << 3) | ((pSquares & cEvenRows) << 4);
+	case DOWN_RIGHT:
+		return ((pSquares & cOddRows) << 4) | ((pSquares & cEvenRows & ~cRightEdge) << 5);
+	case UP_LEFT:
+		return ((pSquares & cOddRows & ~cLeftEdge) >> 5) | ((pSquares & cEvenRows) >> 4);
+	default:
+		return ((pSquares & cOddRows) >> 4) | ((pSquares & cEvenRows & ~cRightEdge) >> 3);
+	}
+}
+
+///returns the number of set bits in \p pSquares
+inline int popCount(uint32_t pSquares)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt(pSquares);
+#else
+	return __builtin_popcount(pSquares);
+#endif
+}
+
+///returns the index of the lowest set bit in \p pSquares (which must not be 0)
+inline int lowestBit(uint32_t pSquares)
+{
+#ifdef _MSC_VER
+	unsigned long lIndex;
+	_BitScanForward(&lIndex, pSquares);
+	return (int)lIndex;
+#else
+	return __builtin_ctz(pSquares);
+#endif
+}
+
+///returns the bitboard with only cell \p pCell set
+inline uint32_t cellBit(int pCell)
+{
+	return 1U << pCell;
+}
+
+/*namespace checkers*/ }
+
+#endif
@@ -0,0 +1,512 @@
+#include "endgame_database.hpp"
+#include "../common/deadline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace checkers
+{
+
+using common::Deadline;
+
+const char EndgameDatabase::cMagic[8] = { 'C', 'K', 'R', 'S', 'E', 'G', 'D', 'B' };
+
+///the kinds of pieces, as seen by the player to move
+enum EKind
+{
+	OWN_MEN,
+	OWN_KINGS,
+	OTHER_MEN,
+	OTHER_KINGS,
+	NUM_KINDS
+};
+
+///the cells a piece of each kind can be on start at cFirstCell and are cCells
+///in a row: the men of the player to move never stand on the last row, as
+///they would be kings, and the men of the other player never on the first one
+static const int cFirstCell[NUM_KINDS] = { 0, 0, 4, 0 };
+static const int cCells[NUM_KINDS] = { 28, 32, 28, 32 };
+
+///the binomial coefficients up to 32
+class Binomials
+{
+public:
+	Binomials()
+	{
+		std::memset(mTable, 0, sizeof(mTable));
+		for (int n = 0; n <= 32; ++n)
+		{
+			mTable[n][0] = 1;
+			for (int k = 1; k <= n; ++k)
+				mTable[n][k] = mTable[n-1][k-1] + (k < n ? mTable[n-1][k] : 0);
+		}
+	}
+
+	uint64_t operator()(int pN, int pK) const    {    return pK > pN ? 0 : mTable[pN][pK];    }
+
+private:
+	uint64_t mTable[33][33];
+};
+
+static const Binomials cChoose;
+
+///returns \p pSquares with cell i moved to cell 31-i
+static uint32_t rotate(uint32_t pSquares)
+{
+	pSquares = ((pSquares >> 1) & 0x55555555U) | ((pSquares & 0x55555555U) << 1);
+	pSquares = ((pSquares >> 2) & 0x33333333U) | ((pSquares & 0x33333333U) << 2);
+	pSquares = ((pSquares >> 4) & 0x0f0f0f0fU) | ((pSquares & 0x0f0f0f0fU) << 4);
+	pSquares = ((pSquares >> 8) & 0x00ff00ffU) | ((pSquares & 0x00ff00ffU) << 8);
+	return (pSquares >> 16) | (pSquares << 16);
+}
+
+///splits the pieces into \p pKinds, as seen by \p pPlayer, the player to move
+static void split(uint32_t pRed, uint32_t pWhite, uint32_t pKings, uint8_t pPlayer, uint32_t *pKinds)
+{
+	uint32_t lOwn = pRed;
+	uint32_t lOther = pWhite;
+	if (pPlayer == CELL_WHITE)
+	{
+		lOwn = rotate(pWhite);
+		lOther = rotate(pRed);
+		pKings = rotate(pKings);
+	}
+	pKinds[OWN_MEN] = lOwn & ~pKings;
+	pKinds[OWN_KINGS] = lOwn & pKings;
+	pKinds[OTHER_MEN] = lOther & ~pKings;
+	pKinds[OTHER_KINGS] = lOther & pKings;
+}
+
+static void split(const GameState &pState, uint32_t *pKinds)
+{
+	split(pState.getPieces(CELL_RED), pState.getPieces(CELL_WHITE), pState.getKings(), pState.getNextPlayer(), pKinds);
+}
+
+///returns the material of a slice: the number of pieces of each kind, four bits each
+static int material(const uint32_t *pKinds)
+{
+	int lMaterial = 0;
+	for (int k = 0; k < NUM_KINDS; ++k)
+		lMaterial |= popCount(pKinds[k]) << (4 * k);
+	return lMaterial;
+}
+
+///returns the number of pieces of kind \p pKind in \p pMaterial
+static int count(int pMaterial, int pKind)
+{
+	return (pMaterial >> (4 * pKind)) & 15;
+}
+
+///returns the material of the positions after a move that captures nothing
+///and promotes no man: the same pieces, seen by the other player
+static int swapped(int pMaterial)
+{
+	return ((pMaterial & 0xff) << 8) | (pMaterial >> 8);
+}
+
+///returns the number of positions in the slice of \p pMaterial
+static uint64_t sliceSize(int pMaterial)
+{
+	uint64_t lSize = 1;
+	for (int k = 0; k < NUM_KINDS; ++k)
+		lSize *= cChoose(cCells[k], count(pMaterial, k));
+	return lSize;
+}
+
+///returns the index of the position in its slice: the rank of the cells of
+///each kind of piece among the sets of as many cells, one kind after the other
+static uint64_t index(const uint32_t *pKinds)
+{
+	uint64_t lIndex = 0;
+	for (int k = 0; k < NUM_KINDS; ++k)
+	{
+		uint64_t lRank = 0;
+		int i = 0;
+		for (uint32_t lPieces = pKinds[k] >> cFirstCell[k]; lPieces; lPieces &= lPieces - 1)
+			lRank += cChoose(lowestBit(lPieces), ++i);
+		lIndex = lIndex * cChoose(cCells[k], i) + lRank;
+	}
+	return lIndex;
+}
+
+///the reverse of index(): fills \p pKinds with the pieces of position \p pIndex
+///of the slice of \p pMaterial, returns false if pieces share a cell
+static bool position(int pMaterial, uint64_t pIndex, uint32_t *pKinds)
+{
+	uint32_t lTaken = 0;
+	bool lValid = true;
+	for (int k = NUM_KINDS - 1; k >= 0; --k)
+	{
+		int lCount = count(pMaterial, k);
+		uint64_t lCombinations = cChoose(cCells[k], lCount);
+		uint64_t lRank = pIndex % lCombinations;
+		pIndex /= lCombinations;
+
+		pKinds[k] = 0;
+		int lCell = cCells[k] - 1;
+		for (int i = lCount; i > 0; --i)
+		{
+			while (cChoose(lCell, i) > lRank)
+				--lCell;
+			lRank -= cChoose(lCell, i);
+			pKinds[k] |= cellBit(lCell + cFirstCell[k]);
+		}
+		lValid = lValid && !(lTaken & pKinds[k]);
+		lTaken |= pKinds[k];
+	}
+	return lValid;
+}
+
+/**
+ * Solves the slices, fewest pieces first
+ *
+ * A move either leaves the pieces as they were, and the position after it is
+ * in the slice with the material swapped(), or it captures or promotes and the
+ * position is in a slice with fewer pieces or fewer men, which is solved
+ * before. So each slice is solved together with its swapped() slice, once
+ * those it leads to are known.
+ */
+class EndgameDatabase::Generator
+{
+public:
+	Generator()
+		:	mFailed(false)
+	{
+	}
+
+	///solves the slice of \p pMaterial and its swapped() slice, returns false
+	///if a position needs more plies than a byte can hold
+	bool solve(int pMaterial);
+
+	///returns the solved slices by material
+	const std::map<int, std::vector<uint8_t> > &getSolved() const    {    return mSolved;    }
+
+private:
+	///returns the byte stored for the position of \p pKinds, which must be in a
+	///solved slice
+	uint8_t lookup(const uint32_t *pKinds) const;
+
+	///queues position \p pPosition to be solved in \p pPlies plies
+	void queue(uint32_t pPosition, int pPlies);
+
+	///positions are solved the fewest plies first
+	std::vector<std::vector<uint32_t> > mQueue;
+	std::map<int, std::vector<uint8_t> > mSolved;
+	bool mFailed;
+};
+
+uint8_t EndgameDatabase::Generator::lookup(const uint32_t *pKinds) const
+{
+	// The player to move has no piece, so no move: lost right away
+	if (!(pKinds[OWN_MEN] | pKinds[OWN_KINGS]))
+		return 1;
+	std::map<int, std::vector<uint8_t> >::const_iterator lSlice = mSolved.find(material(pKinds));
+	assert(lSlice != mSolved.end());
+	return lSlice->second[index(pKinds)];
+}
+
+void EndgameDatabase::Generator::queue(uint32_t pPosition, int pPlies)
+{
+	// The byte holds the plies plus one
+	if (pPlies >= 255)
+	{
+		mFailed = true;
+		return;
+	}
+	mQueue[pPlies].push_back(pPosition);
+}
+
+bool EndgameDatabase::Generator::solve(int pMaterial)
+{
+	// The positions of both slices are numbered one after the other
+	int lMaterials[2] = { pMaterial, swapped(pMaterial) };
+	int lSlices = lMaterials[1] == lMaterials[0] ? 1 : 2;
+	uint64_t lFirst[3] = { 0, sliceSize(lMaterials[0]), 0 };
+	lFirst[2] = lFirst[1] + (lSlices == 2 ? sliceSize(lMaterials[1]) : 0);
+	uint32_t lTotal = (uint32_t)lFirst[lSlices];
+
+	enum
+	{
+		SOLVED = 1,         ///< the value is known
+		WINNING = 2,        ///< a move to a lost position is known
+		UNLOSABLE = 4       ///< a move to a position that is not won is known
+	};
+	std::vector<uint8_t> lValue(lTotal, 0);
+	std::vector<uint8_t> lFlags(lTotal, 0);
+	std::vector<uint8_t> lUnsolved(lTotal, 0);     ///< moves that stay in the two slices, not yet solved
+	std::vector<uint8_t> lLongest(lTotal, 0);      ///< the most plies of the won positions moves lead to
+	mQueue.assign(256, std::vector<uint32_t>());
+
+	// Count the moves of each position that stay in the two slices, and look up
+	// the positions the others lead to
+	MoveList lMoves;
+	GameState::UndoInfo lUndo;
+	uint32_t lKinds[NUM_KINDS];
+	for (uint32_t p = 0; p < lTotal; ++p)
+	{
+		int s = p < lFirst[1] ? 0 : 1;
+		if (!position(lMaterials[s], p - lFirst[s], lKinds))
+		{
+			lFlags[p] = SOLVED;
+			continue;
+		}
+
+		GameState lState(lKinds[OWN_MEN] | lKinds[OWN_KINGS], lKinds[OTHER_MEN] | lKinds[OTHER_KINGS],
+		                 lKinds[OWN_KINGS] | lKinds[OTHER_KINGS], CELL_RED);
+		lState.generateMoves(lMoves);
+		if (lMoves[0].isEOG())
+		{
+			queue(p, 0);
+			continue;
+		}
+
+		int lWin = 256;
+		for (int i = 0; i < lMoves.size(); ++i)
+		{
+			lState.doMove(lMoves[i], lUndo);
+			uint32_t lAfter[NUM_KINDS];
+			split(lState, lAfter);
+			int lMaterial = material(lAfter);
+			if (lMaterial == lMaterials[0] || lMaterial == lMaterials[1])
+				++lUnsolved[p];
+			else
+			{
+				int lPlies = lookup(lAfter) - 1;
+				if (lPlies < 0)
+					lFlags[p] |= UNLOSABLE;
+				else if (lPlies % 2 == 0)
+				{
+					lFlags[p] |= UNLOSABLE;
+					lWin = std::min(lWin, lPlies + 1);
+				}
+				else
+					lLongest[p] = (uint8_t)std::max<int>(lLongest[p], lPlies);
+			}
+			lState.undoMove(lMoves[i], lUndo);
+		}
+
+		if (lWin < 256)
+		{
+			lFlags[p] |= WINNING;
+			queue(p, lWin);
+		}
+		else if (lUnsolved[p] == 0 && !(lFlags[p] & UNLOSABLE))
+			queue(p, lLongest[p] + 1);
+	}
+
+	// Solve the positions the fewest plies first. A position that leads to a
+	// lost one is won in one more ply; one whose moves all lead to won
+	// positions is lost once the last of them is solved. Those are found by
+	// taking back the moves of the other player, who moved last.
+	for (int lPlies = 0; lPlies < 255 && !mFailed; ++lPlies)
+	{
+		for (size_t q = 0; q < mQueue[lPlies].size(); ++q)
+		{
+			uint32_t p = mQueue[lPlies][q];
+			if (lFlags[p] & SOLVED)
+				continue;
+			lFlags[p] |= SOLVED;
+			lValue[p] = (uint8_t)(lPlies + 1);
+			bool lLost = lPlies % 2 == 0;
+
+			int s = p < lFirst[1] ? 0 : 1;
+			position(lMaterials[s], p - lFirst[s], lKinds);
+			uint32_t lRed = lKinds[OWN_MEN] | lKinds[OWN_KINGS];
+			uint32_t lWhite = lKinds[OTHER_MEN] | lKinds[OTHER_KINGS];
+			uint32_t lEmpty = ~(lRed | lWhite);
+			for (uint32_t lPieces = lWhite; lPieces; lPieces &= lPieces - 1)
+			{
+				uint32_t lTo = cellBit(lowestBit(lPieces));
+				bool lIsKing = lKinds[OTHER_KINGS] & lTo;
+				// White men move up the board, so they came from below
+				for (int d = DOWN_LEFT; d <= (lIsKing ? UP_RIGHT : DOWN_RIGHT); ++d)
+				{
+					uint32_t lFrom = shift(lTo, d) & lEmpty;
+					if (!lFrom)
+						continue;
+					GameState lBefore(lRed, (lWhite & ~lTo) | lFrom,
+					                  lKinds[OWN_KINGS] | (lIsKing ? (lKinds[OTHER_KINGS] & ~lTo) | lFrom : lKinds[OTHER_KINGS]),
+					                  CELL_WHITE);
+					// A move that captures nothing is only allowed when no capture is
+					if (lBefore.getJumpers())
+						continue;
+					uint32_t lBeforeKinds[NUM_KINDS];
+					split(lBefore, lBeforeKinds);
+					int t = material(lBeforeKinds) == lMaterials[0] ? 0 : 1;
+					uint32_t b = (uint32_t)(lFirst[t] + index(lBeforeKinds));
+					if (lFlags[b] & SOLVED)
+						continue;
+
+					if (lLost)
+					{
+						// Queued again if a slower win was known: the first one taken is the fastest
+						lFlags[b] |= WINNING;
+						queue(b, lPlies + 1);
+					}
+					else
+					{
+						lLongest[b] = (uint8_t)std::max<int>(lLongest[b], lPlies);
+						if (--lUnsolved[b] == 0 && !(lFlags[b] & (UNLOSABLE | WINNING)))
+							queue(b, lLongest[b] + 1);
+					}
+				}
+			}
+		}
+	}
+	if (mFailed)
+		return false;
+
+	// The positions left are drawn: neither player can force the other out of moves
+	for (int s = 0; s < lSlices; ++s)
+		mSolved[lMaterials[s]].assign(lValue.begin() + lFirst[s], lValue.begin() + lFirst[s + 1]);
+	return true;
+}
+
+///orders the slices so that every slice comes after those its moves lead to:
+///fewer pieces first, then fewer men
+static bool solvedBefore(int pLeft, int pRight)
+{
+	int lLeftPieces = count(pLeft, OWN_MEN) + count(pLeft, OWN_KINGS) + count(pLeft, OTHER_MEN) + count(pLeft, OTHER_KINGS);
+	int lRightPieces = count(pRight, OWN_MEN) + count(pRight, OWN_KINGS) + count(pRight, OTHER_MEN) + count(pRight, OTHER_KINGS);
+	if (lLeftPieces != lRightPieces)
+		return lLeftPieces < lRightPieces;
+	int lLeftMen = count(pLeft, OWN_MEN) + count(pLeft, OTHER_MEN);
+	int lRightMen = count(pRight, OWN_MEN) + count(pRight, OTHER_MEN);
+	if (lLeftMen != lRightMen)
+		return lLeftMen < lRightMen;
+	return pLeft < pRight;
+}
+
+bool EndgameDatabase::generate(const std::string &pPath, int pMaxPieces)
+{
+	if (pMaxPieces < 2 || pMaxPieces > cMaxPieces)
+		return false;
+
+	// Every material with at least one piece on each side
+	std::vector<int> lMaterials;
+	for (int om = 0; om <= pMaxPieces; ++om)
+		for (int ok = 0; om + ok <= pMaxPieces; ++ok)
+			for (int xm = 0; om + ok + xm <= pMaxPieces; ++xm)
+				for (int xk = 0; om + ok + xm + xk <= pMaxPieces; ++xk)
+					if (om + ok > 0 && xm + xk > 0)
+						lMaterials.push_back(om | (ok << 4) | (xm << 8) | (xk << 12));
+	std::sort(lMaterials.begin(), lMaterials.end(), solvedBefore);
+
+	Deadline lStart = Deadline::now();
+	Generator lGenerator;
+	for (size_t i = 0; i < lMaterials.size(); ++i)
+	{
+		if (lGenerator.getSolved().count(lMaterials[i]))
+			continue;
+		if (!lGenerator.solve(lMaterials[i]))
+		{
+			std::cerr << "Too many plies to store in slice " << std::hex << lMaterials[i] << std::dec << std::endl;
+			return false;
+		}
+	}
+	const std::map<int, std::vector<uint8_t> > &lSolved = lGenerator.getSolved();
+
+	Header lHeader;
+	std::memset(&lHeader, 0, sizeof(lHeader));
+	std::memcpy(lHeader.mMagic, cMagic, sizeof(cMagic));
+	lHeader.mVersion = cVersion;
+	lHeader.mMaxPieces = (uint32_t)pMaxPieces;
+	lHeader.mSlices = (uint32_t)lSolved.size();
+
+	std::vector<SliceEntry> lEntries;
+	uint64_t lOffset = sizeof(Header) + lSolved.size() * sizeof(SliceEntry);
+	int lCounts[3] = { 0, 0, 0 };
+	for (std::map<int, std::vector<uint8_t> >::const_iterator it = lSolved.begin(); it != lSolved.end(); ++it)
+	{
+		SliceEntry lEntry;
+		std::memset(&lEntry, 0, sizeof(lEntry));
+		lEntry.mMaterial = (uint32_t)it->first;
+		lEntry.mOffset = lOffset;
+		lEntry.mSize = it->second.size();
+		lEntries.push_back(lEntry);
+		lOffset += lEntry.mSize;
+		for (size_t p = 0; p < it->second.size(); ++p)
+			++lCounts[it->second[p] == 0 ? 1 : it->second[p] % 2 == 0 ? 2 : 0];
+	}
+
+	std::ofstream lFile(pPath.c_str(), std::ios::binary | std::ios::trunc);
+	lFile.write(reinterpret_cast<const char*>(&lHeader), sizeof(lHeader));
+	lFile.write(reinterpret_cast<const char*>(&lEntries[0]), lEntries.size() * sizeof(SliceEntry));
+	for (std::map<int, std::vector<uint8_t> >::const_iterator it = lSolved.begin(); it != lSolved.end(); ++it)
+		lFile.write(reinterpret_cast<const char*>(&it->second[0]), it->second.size());
+	lFile.close();
+	if (!lFile)
+		return false;
+
+	// Positions where pieces share a cell are counted as draws
+	std::cerr << "solved:" << lSolved.size() << " slices:" << lOffset << " bytes:wins:" << lCounts[2]
+	          << ":draws:" << lCounts[1] << ":losses:" << lCounts[0] << ":time:" << Deadline::now() - lStart << std::endl;
+	return true;
+}
+
+bool EndgameDatabase::open(const std::string &pPath)
+{
+	mSlices.clear();
+	mMaxPieces = 0;
+	if (!mFile.open(pPath))
+		return false;
+
+	Header lHeader;
+	bool lValid = mFile.size() >= sizeof(lHeader);
+	if (lValid)
+	{
+		std::memcpy(&lHeader, mFile.data(), sizeof(lHeader));
+		lValid = std::memcmp(lHeader.mMagic, cMagic, sizeof(cMagic)) == 0 && lHeader.mVersion == cVersion
+			&& lHeader.mMaxPieces >= 2 && lHeader.mMaxPieces <= (uint32_t)cMaxPieces
+			&& mFile.size() >= sizeof(lHeader) + (uint64_t)lHeader.mSlices * sizeof(SliceEntry);
+	}
+
+	std::vector<const uint8_t*> lSlices(1 << (4 * NUM_KINDS), (const uint8_t*)NULL);
+	for (uint32_t i = 0; lValid && i < lHeader.mSlices; ++i)
+	{
+		SliceEntry lEntry;
+		std::memcpy(&lEntry, mFile.data() + sizeof(lHeader) + i * sizeof(SliceEntry), sizeof(lEntry));
+		lValid = lEntry.mMaterial < lSlices.size() && lEntry.mSize == sliceSize(lEntry.mMaterial)
+			&& lEntry.mOffset + lEntry.mSize <= mFile.size();
+		if (lValid)
+			lSlices[lEntry.mMaterial] = reinterpret_cast<const uint8_t*>(mFile.data() + lEntry.mOffset);
+	}
+	if (!lValid)
+	{
+		mFile.close();
+		return false;
+	}
+
+	mSlices.swap(lSlices);
+	mMaxPieces = (int)lHeader.mMaxPieces;
+	return true;
+}
+
+bool EndgameDatabase::probe(const GameState &pState, Result &pResult) const
+{
+	if (popCount(pState.getPieces(CELL_RED) | pState.getPieces(CELL_WHITE)) > mMaxPieces)
+		return false;
+
+	uint32_t lKinds[NUM_KINDS];
+	split(pState, lKinds);
+	const uint8_t *lSlice = mSlices[material(lKinds)];
+	if (!lSlice)
+		return false;
+
+	uint8_t lValue = lSlice[index(lKinds)];
+	if (lValue == 0)
+	{
+		pResult.mOutcome = DRAW;
+		pResult.mPlies = 0;
+	}
+	else
+	{
+		pResult.mPlies = lValue - 1;
+		pResult.mOutcome = pResult.mPlies % 2 == 0 ? LOSS : WIN;
+	}
+	return true;
+}
+
+/*namespace checkers*/ }
@@ -0,0 +1,109 @@
+#ifndef _CHECKERS_ENDGAME_DATABASE_HPP_
+#define _CHECKERS_ENDGAME_DATABASE_HPP_
+
+#include "gamestate.hpp"
+#include "../common/mapped_file.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace checkers {
+
+/**
+ * Endgame databases: the outcome with perfect play of every position with few pieces
+ *
+ * generate() solves every position with up to a given number of pieces by
+ * retrograde analysis, from the positions where the player to move has no move
+ * left back to those that lead to them, and writes for each position whether
+ * the player to move wins, draws or loses, and in how many plies the loser
+ * runs out of moves. open() maps such a file, and probe() looks a position up
+ * in it.
+ *
+ * Positions are stored as seen by the player to move: for white the board is
+ * rotated and the colors swapped (see GameState::reversed()), so the player to
+ * move always moves down the board. The positions with the same number of men
+ * and kings on each side form a slice, in which a position is indexed by the
+ * cells of each kind of piece, so a probe reads a single byte. The file is a
+ * Header, a SliceEntry for each slice and the slices, one byte per position:
+ * 0 for a draw, otherwise one more than the number of plies left, which is odd
+ * for the positions that are lost and even for those that are won. Numbers are
+ * stored in the byte order of the machine that generated the file.
+ *
+ * The positions are solved as if there were no limit to the moves without a
+ * capture, so a win is only certain if it takes fewer plies than the moves
+ * left until the game is drawn (see GameState::getMovesUntilDraw()).
+ */
+class EndgameDatabase
+{
+public:
+    enum EOutcome
+    {
+        LOSS = -1,      ///< the player to move loses
+        DRAW = 0,       ///< the game is drawn
+        WIN = 1         ///< the player to move wins
+    };
+
+    ///the result of a probe
+    struct Result
+    {
+        EOutcome mOutcome;  ///< for the player to move
+        int mPlies;         ///< the number of plies until the loser has no move left
+    };
+
+    ///the most pieces a database can be generated for
+    static const int cMaxPieces = 8;
+
+    EndgameDatabase()
+        :   mMaxPieces(0)
+    {
+    }
+
+    ///solves the positions with up to \p pMaxPieces pieces and writes the
+    ///database to \p pPath, returns false if it cannot be generated or written
+    static bool generate(const std::string &pPath, int pMaxPieces);
+
+    ///maps the database at \p pPath, returns false if it is missing or invalid
+    bool open(const std::string &pPath);
+
+    ///returns true while a database is mapped
+    bool isOpen() const    {    return mMaxPieces > 0;    }
+
+    ///returns the most pieces of the positions in the database
+    int getMaxPieces() const    {    return mMaxPieces;    }
+
+    ///looks up \p pState, which must not be the end of the game, returns false
+    ///if it is not in the database
+    bool probe(const GameState &pState, Result &pResult) const;
+
+private:
+    struct Header
+    {
+        char mMagic[8];         ///< cMagic
+        uint32_t mVersion;      ///< cVersion
+        uint32_t mMaxPieces;    ///< the most pieces of the positions
+        uint32_t mSlices;       ///< the number of SliceEntry after the header
+        uint32_t mReserved;
+    };
+
+    struct SliceEntry
+    {
+        uint32_t mMaterial;     ///< the pieces of each kind (see material())
+        uint32_t mReserved;
+        uint64_t mOffset;       ///< where the slice starts in the file
+        uint64_t mSize;         ///< the number of positions in the slice
+    };
+
+    ///solves the slices one after the other (see endgame_database.cpp)
+    class Generator;
+
+    static const char cMagic[8];
+    static const uint32_t cVersion = 1;
+
+    common::MappedFile mFile;
+    std::vector<const uint8_t*> mSlices;    ///< the slices by material
+    int mMaxPieces;
+};
+
+/*namespace checkers*/ }
+
+#endif
@@ -1,106 +1,112 @@
-
 #include "game_algorithm.h"
 #include <float.h>
-#include <cstdlib>
-#include <chrono>
+#include <cmath>
+
+static const int MAX_DEPTH = 64;
+// The clock is read about every millisecond (see DeadlinePoll)
+static const double LOWER_TIME_LIMIT = 0.005;
+// With several threads the search only stops once all of them have noticed the
+// deadline, which takes longer when they are not all running
+static const double THREADED_TIME_LIMIT = 0.02;
+// A new iteration is only started when the previous one, scaled by this factor,
+// still fits in the remaining time
+static const double ITERATION_GROWTH = 3.0;
+// Half the width of the aspiration window around the value of the previous iteration,
+// which is only used while the value is a material ratio rather than a win or a draw
+static const float ASPIRATION_WINDOW = 0.25f;
+static const float ASPIRATION_LIMIT = FLT_MAX / 8.0f;
+
+common::Search<GameAlgorithm::Game> GameAlgorithm::search;
+const EndgameDatabase* GameAlgorithm::endgame_database = NULL;
 
-static const int MAX_DEPTH = 10;
-static const double LOWER_TIME_LIMIT = 0.001;
+checkers::GameState GameAlgorithm::get_best_move(const Deadline& p_due, const GameState& p_starting_move)
+{
+	return GameState(p_starting_move, search.bestMove(p_due, p_starting_move, p_starting_move.getNextPlayer()));
+}
 
-static const double time_left(const Deadline& p_due)
+void GameAlgorithm::set_hash_size(size_t megabytes)
 {
-	return p_due - Deadline::now();
+	search.setHashSize(megabytes);
 }
 
-vector<vector<int>> GameAlgorithm::lookup_table = GameAlgorithm::init_zobris(32, 2);
+void GameAlgorithm::set_threads(int threads)
+{
+	search.setThreads(threads);
+}
 
-unordered_map<int, GameAlgorithm::GameStateHashValue> GameAlgorithm::transposition_table;
+void GameAlgorithm::set_verbose(bool verbose)
+{
+	search.setVerbose(verbose);
+}
 
-checkers::GameState GameAlgorithm::get_best_move(const Deadline& p_due, const GameState& p_starting_move)
+void GameAlgorithm::start_pondering(const GameState& p_state)
 {
-	transposition_table = unordered_map<int, GameStateHashValue>();
-	return nega_max(p_due, p_starting_move, p_starting_move.getNextPlayer(), MAX_DEPTH, 1, -FLT_MAX, FLT_MAX).state;
+	search.startPondering(p_state);
 }
 
-GameAlgorithm::GameStateEvaluation GameAlgorithm::nega_max(const Deadline& p_due, const GameState& p_state, uint8_t our_player_type, int depth, int color, float alpha, float beta)
+void GameAlgorithm::new_game()
 {
-	float alpha_orig = alpha;
-	//////////////////////////////////////////////////////////////////////////
-	if (p_state.getNextPlayer() == our_player_type)
-	{
-		auto hashed_state_it = transposition_table.find(get_zobris_hash(lookup_table, p_state));
-		if (hashed_state_it != transposition_table.end())
-		{
-			GameStateHashValue hashed_state = hashed_state_it->second;
-			if (hashed_state.depth >= depth)
-			{
-				switch (hashed_state.flag)
-				{
-				case EXACT:
-					return{ p_state, hashed_state.value };
-				case LOWERBOUND:
-					if (hashed_state.value > alpha)
-						alpha = hashed_state.value;
-					break;
-				case UPPERBOUND:
-					if (hashed_state.value < beta)
-						beta = hashed_state.value;
-					break;
-				}
-				if (alpha >= beta)
-					return{ p_state, hashed_state.value };
-			}
-		}
-	}
-	//////////////////////////////////////////////////////////////////////////
-	vector<GameState> next_states;
-	p_state.findPossibleMoves(next_states);
-	int num_next_states = next_states.size();
+	search.newGame();
+}
 
-	if (depth == 0 || num_next_states == 0)
+void GameAlgorithm::set_endgame_database(const EndgameDatabase* database)
+{
+	endgame_database = database;
+}
+
+bool GameAlgorithm::Game::isDecided(float value)
+{
+	return fabs(value) >= FLT_MAX / 2.0f;
+}
+
+bool GameAlgorithm::Game::probe(const GameState& p_state, uint8_t our_player_type, float& value)
+{
+	EndgameDatabase::Result result;
+	if (!endgame_database || !endgame_database->probe(p_state, result))
+		return false;
+
+	// Valued like a drawn game
+	if (result.mOutcome == EndgameDatabase::DRAW)
 	{
-		float state_evaluation = evaluate_state(p_state, our_player_type);
-		return GameStateEvaluation{ p_state, color * state_evaluation };
+		value = FLT_MAX / 4.0f;
+		return true;
 	}
-	//////////////////////////////////////////////////////////////////////////
-	GameStateEvaluation best_value{ p_state, -FLT_MAX };
-	for (const GameState& next_state : next_states)
-	{
-		GameStateEvaluation v = nega_max(p_due, next_state, our_player_type, depth - 1, -color, -beta, -alpha);
-		v.value = -v.value; //Multiply by -1 when back-propagating
 
-		if (v.value > best_value.value)
-		{
-			best_value.state = next_state;
-			best_value.value = v.value;
-		}
-		if (v.value > alpha)
-		{
-			alpha = v.value;
-		}
+	// The database knows nothing of the moves until draw: a win that takes too
+	// long may be a draw, so the position is searched
+	if (result.mPlies >= p_state.getMovesUntilDraw())
+		return false;
 
-		if (time_left(p_due) < LOWER_TIME_LIMIT)
-			return best_value;
-		if (alpha >= beta) {
-			break;
-		}
-	}
-	//////////////////////////////////////////////////////////////////////////
-	if (p_state.getNextPlayer() == our_player_type) {
-		GameStateHashValue new_hashtable_value;
-		new_hashtable_value.value = best_value.value;
-		if (best_value.value <= alpha_orig)
-			new_hashtable_value.flag = UPPERBOUND;
-		else if (best_value.value >= beta)
-			new_hashtable_value.flag = LOWERBOUND;
-		else
-			new_hashtable_value.flag = EXACT;
-		new_hashtable_value.depth = depth;
-
-		transposition_table[get_zobris_hash(lookup_table, p_state)] = new_hashtable_value;
-	}
-	//////////////////////////////////////////////////////////////////////////
-	return best_value;
+	// Worth more than the wins the search finds, the more so the faster they are
+	float win_value = FLT_MAX / 2.0f * (1.0f + (256 - result.mPlies) / 1024.0f);
+	bool we_win = (result.mOutcome == EndgameDatabase::WIN) == (p_state.getNextPlayer() == our_player_type);
+	value = we_win ? win_value : -win_value;
+	return true;
+}
+
+int GameAlgorithm::Game::maxDepth(const GameState&)
+{
+	return MAX_DEPTH;
+}
+
+float GameAlgorithm::Game::aspirationWindow()
+{
+	return ASPIRATION_WINDOW;
+}
+
+float GameAlgorithm::Game::aspirationLimit()
+{
+	return ASPIRATION_LIMIT;
+}
+
+double GameAlgorithm::Game::timeMargin(int threads)
+{
+	return threads > 1 ? THREADED_TIME_LIMIT : LOWER_TIME_LIMIT;
+}
+
+double GameAlgorithm::Game::iterationGrowth()
+{
+	return ITERATION_GROWTH;
 }
 
 float GameAlgorithm::evaluate_state(const GameState& p_state, const uint8_t our_player_type)
@@ -129,71 +135,14 @@ float GameAlgorithm::evaluate_state(const GameState& p_state, const uint8_t our_
 		}
 	}
 
-	int red_count = 0;
-	int white_count = 0;
-
-	for (int i = 0; i < p_state.cSquares; ++i)
-	{
-		const uint8_t& cell_status = p_state.at(i);
-		if (cell_status&CELL_RED)
-		{
-			red_count += cell_status&CELL_KING ? 2 : 1;
-		}
-		else if (cell_status&CELL_WHITE)
-		{
-			white_count += cell_status&CELL_KING ? 2 : 1;
-		}
-	}
+	// Kings count twice
+	const uint32_t red = p_state.getPieces(CELL_RED);
+	const uint32_t white = p_state.getPieces(CELL_WHITE);
+	const int red_count = popCount(red) + popCount(red & p_state.getKings());
+	const int white_count = popCount(white) + popCount(white & p_state.getKings());
 
 	if (our_player_type == CELL_RED)
 		return red_count / (((float)white_count));
 	else
 		return white_count / (((float)red_count));
 }
-
-std::vector<std::vector<int>> GameAlgorithm::init_zobris(int n_positions, int n_pieces)
-{
-	//init rand
-	chrono::milliseconds ms = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch());
-	srand(ms.count());
-
-	vector<vector<int>> table(n_positions, vector<int>(n_pieces));
-	for (int i = 0; i < n_positions; ++i)
-	{
-		for (int j = 0; j < n_pieces; ++j)
-		{
-			table[i][j] = rand();
-		}
-	}
-	return table;
-}
-
-/************************************************************************/
-/* function hash(board):
-	   h := 0
-	   for i from 1 to 64:      # loop over the board positions
-		   if board[i] != empty:
-			   j := the piece at board[i], as listed in the constant indices, above
-			   h := h XOR table[i][j]
-	   return h                                                                     */
-	   /************************************************************************/
-
-int GameAlgorithm::get_zobris_hash(const vector<vector<int>>& lookup_table, const GameState& board_state)
-{
-	int hash = 0;
-	for (int i = 0; i < board_state.cSquares; ++i)
-	{
-		if (board_state.at(i) != CELL_EMPTY)
-		{
-			int j;
-			if (board_state.at(i)&CELL_RED)
-				j = 0;
-			else
-				j = 1;
-
-			hash ^= lookup_table[i][j];
-		}
-	}
-	return hash;
-}
-
@@ -1,46 +1,62 @@
 #pragma once
 
 #include "gamestate.hpp"
-#include "deadline.hpp"
-#include <unordered_map>
+#include "endgame_database.hpp"
+#include "../common/search.hpp"
 
 using namespace checkers;
+using common::Deadline;
 using namespace std;
 
 class GameAlgorithm
 {
-	struct GameStateEvaluation {
-		GameState state;
-		float value;
-
-		bool operator < (const GameStateEvaluation& gse) const
-		{
-			return (value > gse.value);
-		}
-	} typedef GameStateEvaluation;
-
-	enum FLAG
-	{
-		EXACT,
-		LOWERBOUND,
-		UPPERBOUND
-	};
-
-	struct GameStateHashValue {
-		float value;
-		FLAG flag;
-		int depth;
-	} typedef GameStateHashValue;
-
-	static vector<vector<int>> lookup_table;
-	static unordered_map<int, GameStateHashValue> transposition_table;
-
 public:
 	static GameState get_best_move(const Deadline& p_due, const GameState& p_starting_state);
+	// The transposition table is kept for the whole game; this sets its size in megabytes
+	static void set_hash_size(size_t megabytes);
+	// Sets the number of threads the root moves are searched on
+	static void set_threads(int threads);
+	// Sets whether the searches log their progress to std::cerr
+	static void set_verbose(bool verbose);
+	// Searches, until the next move is asked for, the position after the reply expected
+	// to our move that led to p_state
+	static void start_pondering(const GameState& p_state);
+	// Forgets what the searches of the previous game found
+	static void new_game();
+	// Positions with few pieces are looked up in the database rather than searched,
+	// none if it is NULL
+	static void set_endgame_database(const EndgameDatabase* database);
 private:
 
-	static GameStateEvaluation nega_max(const Deadline& p_due, const GameState& p_state, uint8_t our_player_type, int depth, int color, float alpha, float beta);
 	static float evaluate_state(const GameState& p_state, const uint8_t our_player_type);
-	static vector<vector<int>> init_zobris(int n_positions, int n_pieces);
-	static int get_zobris_hash(const vector<vector<int>>& lookup_table, const GameState& state);
-};
\ No newline at end of file
+
+	// The game as seen by the search (see common::Search). Values are from our point
+	// of view: the material ratio, or FLT_MAX / 2 for a won game.
+	struct Game
+	{
+		typedef checkers::GameState State;
+		typedef checkers::Move Move;
+		typedef checkers::MoveList MoveList;
+		typedef float Value;
+
+		static float evaluate(const GameState& p_state, uint8_t our_player_type) { return evaluate_state(p_state, our_player_type); }
+		static bool isDecided(float value);
+		static bool probe(const GameState& p_state, uint8_t our_player_type, float& value);
+		// Jumps are mandatory, so the horizon is only reached once no capture is left
+		static bool isQuiet(const GameState& p_state) { return !p_state.getJumpers(); }
+		// The player to move is part of the key, and the table stores the index of the
+		// best move in generation order
+		static uint64_t key(const GameState& p_state, int& symmetry) { symmetry = 0; return p_state.getHash(); }
+		static int packMove(const MoveList&, int index, int) { return index; }
+		static int unpackMove(const MoveList& moves, int packed, int) { return packed < moves.size() ? packed : -1; }
+		static void pruneRootMoves(GameState&, MoveList&) {}
+		static int maxDepth(const GameState& p_state);
+		static float aspirationWindow();
+		static float aspirationLimit();
+		static double timeMargin(int threads);
+		static double iterationGrowth();
+	};
+
+	static common::Search<Game> search;
+	static const EndgameDatabase* endgame_database;
+};
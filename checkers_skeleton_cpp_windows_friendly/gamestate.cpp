@@ -6,6 +6,53 @@
 namespace checkers
 {
 
+/**
+ * The random keys of the Zobrist hash
+ *
+ * They are generated with splitmix64 from a fixed seed, so keys are the same
+ * on every run.
+ */
+struct ZobristKeys
+{
+	static const int cDrawBuckets = 21;
+
+	uint64_t mPiece[GameState::cSquares][8];	///< indexed by cell and cell contents
+	uint64_t mDraw[cDrawBuckets];			///< indexed by drawBucket()
+	uint64_t mWhiteToMove;
+	uint64_t mEndOfGame;
+
+	ZobristKeys()
+	{
+		uint64_t lSeed = 0x4b1d5eed2380c0deULL;
+		for (int i = 0; i < GameState::cSquares; ++i)
+			for (int j = 0; j < 8; ++j)
+				mPiece[i][j] = j == CELL_EMPTY ? 0 : next(lSeed);
+		for (int i = 0; i < cDrawBuckets; ++i)
+			mDraw[i] = next(lSeed);
+		mWhiteToMove = next(lSeed);
+		mEndOfGame = next(lSeed);
+	}
+
+	static uint64_t next(uint64_t &pState)
+	{
+		uint64_t lZ = (pState += 0x9e3779b97f4a7c15ULL);
+		lZ = (lZ ^ (lZ >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		lZ = (lZ ^ (lZ >> 27)) * 0x94d049bb133111ebULL;
+		return lZ ^ (lZ >> 31);
+	}
+
+	///the last 16 moves before a draw get a key each, earlier ones share one per 8
+	static int drawBucket(int pMovesUntilDraw)
+	{
+		if (pMovesUntilDraw < 16)
+			return pMovesUntilDraw < 0 ? 0 : pMovesUntilDraw;
+		int lBucket = 16 + (pMovesUntilDraw - 16) / 8;
+		return lBucket < cDrawBuckets ? lBucket : cDrawBuckets - 1;
+	}
+};
+
+static const ZobristKeys cZobrist;
+
 /**
  * Initializes the board to the starting position
  */
@@ -25,6 +72,8 @@ GameState::GameState()
 	mLastMove = Move(Move::MOVE_BOG);
 	mMovesUntilDraw = cMovesUntilDraw;
 	mNextPlayer = CELL_RED;
+	computeBitboards();
+	mHash = computeHash();
 }
 
 /**
@@ -84,6 +133,35 @@ GameState::GameState(const std::string &pMessage)
 
 	// Set number of moves left until draw
 	mMovesUntilDraw = moves_left;
+	computeBitboards();
+	mHash = computeHash();
+}
+
+/**
+ * Constructs a board from the cells that hold the pieces, with no move made yet
+ *
+ * \param pRed the cells holding a red piece
+ * \param pWhite the cells holding a white piece
+ * \param pKings the cells holding a king of either player
+ * \param pNextPlayer the player to move (CELL_RED or CELL_WHITE)
+ */
+GameState::GameState(uint32_t pRed, uint32_t pWhite, uint32_t pKings, uint8_t pNextPlayer)
+{
+	for (int i = 0; i < cSquares; ++i)
+	{
+		uint32_t lBit = cellBit(i);
+		if (pRed & lBit)
+			mCell[i] = (pKings & lBit) ? CELL_RED | CELL_KING : CELL_RED;
+		else if (pWhite & lBit)
+			mCell[i] = (pKings & lBit) ? CELL_WHITE | CELL_KING : CELL_WHITE;
+		else
+			mCell[i] = CELL_EMPTY;
+	}
+	mLastMove = Move(Move::MOVE_BOG);
+	mMovesUntilDraw = cMovesUntilDraw;
+	mNextPlayer = pNextPlayer;
+	computeBitboards();
+	mHash = computeHash();
 }
 
 /**
@@ -102,6 +180,10 @@ GameState::GameState(const GameState &pRH,const Move &pMove)
     mMovesUntilDraw = pRH.mMovesUntilDraw;
     mNextPlayer     = pRH.mNextPlayer;
     mLastMove       = pRH.mLastMove;
+    mHash           = pRH.mHash;
+    mRed            = pRH.mRed;
+    mWhite          = pRH.mWhite;
+    mKings          = pRH.mKings;
 
     // Perform move
     doMove(pMove);
@@ -123,180 +205,145 @@ GameState GameState::reversed() const
 	}
     result.mNextPlayer ^= (CELL_RED | CELL_WHITE);
     result.mLastMove = mLastMove.reversed();
+    result.computeBitboards();
+    result.mHash = result.computeHash();
     return result;
 }
 
 /**
- * Tries to make a jump from a certain position of the board
+ * Appends to \p pMoves every jump sequence that goes on from cell \p pCell
  *
- * \param pMoves a vector where the valid moves will be inserted
- * \param pOther the \ref ECell code corresponding to the player who is not making the move
- * \param pR the row of the cell we are moving from
- * \param pC the col
- * \param pKing true if the moving piece is a king
- * \param pBuffer a buffer where the list of jump positions is
- * inserted (for multiple jumps)
- * \param pDepth the number of multiple jumps before this attempt
+ * \param pMoves the list where the jumps are appended
+ * \param pCell the cell the piece has reached
+ * \param pOther the pieces of the player who is not making the move
+ * \param pEmpty the empty cells, including the cell the piece started from
+ * \param pFirst the first \ref EDirection the piece may jump in
+ * \param pLast the last \ref EDirection the piece may jump in
+ * \param pBuffer the cells reached so far in the sequence
+ * \param pDepth the number of jumps before this one
  */
-bool GameState::tryJump(std::vector<Move> &pMoves, int pR, int pC,
-             bool pKing, uint8_t *pBuffer, int pDepth) const
+void GameState::expandJumps(MoveList &pMoves, int pCell, uint32_t pOther, uint32_t pEmpty,
+             int pFirst, int pLast, uint8_t *pBuffer, int pDepth)
 {
-    // Remove ourself temporarily
-	uint8_t lOldSelf = at(pR, pC);
-	mutableAt(pR, pC) = CELL_EMPTY;
-
-	pBuffer[pDepth]=rowColToCell(pR,pC);
+    pBuffer[pDepth]=pCell;
 
     bool lFound=false;
-    uint8_t lOther = mNextPlayer ^ (CELL_WHITE|CELL_RED);
-
-    // Try capturing downwards
-    if(mNextPlayer==CELL_RED||pKing)
+    for (int d = pFirst; d <= pLast; ++d)
     {
-        // Try capturing left
-        if((at(pR+1,pC-1)&lOther) && at(pR+2,pC-2)==CELL_EMPTY)
+        uint32_t lOver = shift(cellBit(pCell), d) & pOther;
+        uint32_t lTo = shift(lOver, d) & pEmpty;
+        if (lTo)
         {
+            // The captured piece stays off the board for the rest of the sequence
             lFound=true;
-            uint8_t lOldValue=at(pR+1,pC-1);
-            mutableAt(pR+1,pC-1)=CELL_EMPTY;
-            tryJump(pMoves,pR+2,pC-2,pKing,pBuffer,pDepth+1);
-            mutableAt(pR+1,pC-1)=lOldValue;
-        }
-        // Try capturing right
-        if((at(pR+1,pC+1)&lOther) && at(pR+2,pC+2)==CELL_EMPTY)
-        {
-            lFound=true;
-            uint8_t lOldValue=at(pR+1,pC+1);
-            mutableAt(pR+1,pC+1)=CELL_EMPTY;
-            tryJump(pMoves,pR+2,pC+2,pKing,pBuffer,pDepth+1);
-            mutableAt(pR+1,pC+1)=lOldValue;
-        }
-    }
-    // Try capturing upwards
-    if(mNextPlayer==CELL_WHITE||pKing)
-    {
-        // Try capturing left
-        if((at(pR-1,pC-1)&lOther) && at(pR-2,pC-2)==CELL_EMPTY)
-        {
-            lFound=true;
-            uint8_t lOldValue=at(pR-1,pC-1);
-            mutableAt(pR-1,pC-1)=CELL_EMPTY;
-            tryJump(pMoves,pR-2,pC-2,pKing,pBuffer,pDepth+1);
-            mutableAt(pR-1,pC-1)=lOldValue;
-        }
-        // Try capturing right
-        if((at(pR-1,pC+1)&lOther) && at(pR-2,pC+2)==CELL_EMPTY)
-        {
-            lFound=true;
-            uint8_t lOldValue=at(pR-1,pC+1);
-            mutableAt(pR-1,pC+1)=CELL_EMPTY;
-            tryJump(pMoves,pR-2,pC+2,pKing,pBuffer,pDepth+1);
-            mutableAt(pR-1,pC+1)=lOldValue;
+            expandJumps(pMoves, lowestBit(lTo), pOther & ~lOver, pEmpty | lOver,
+                        pFirst, pLast, pBuffer, pDepth+1);
         }
     }
 
-    // Restore ourself
-	mutableAt(pR, pC) = lOldSelf;
-
     if(!lFound&&pDepth>0)
         pMoves.push_back(Move(pBuffer,pDepth+1));
-
-    return lFound;
 }
 
 /**
- * Tries to make a move from a certain position
+ * Returns a list of all valid moves for \p pWho
  *
- * \param pMoves vector where the valid moves will be inserted
- * \param pCell the cell where the move is tried from
- * \param pOther the \ref ECell code corresponding to the player
- * who is not making the move
- * \param pKing true if the piece is a king
+ * \param pMoves a vector where the list of moves will be appended
+ * \param pWho the \ref ECell code (CELL_OWN or CELL_OTHER) of the
+ * player making the move
  */
-void GameState::tryMove(std::vector<Move> &pMoves, int pCell, bool pKing) const
+void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
 {
-    int lR=cellToRow(pCell);
-    int lC=cellToCol(pCell);
-    // Try moving downwards
-    if(mNextPlayer==CELL_RED||pKing)
-    {
-        // Try moving right
-        if(at(lR+1,lC-1)==CELL_EMPTY)
-            pMoves.push_back(Move(pCell,rowColToCell(lR+1,lC-1)));
-        //try moving left
-        if(at(lR+1,lC+1)==CELL_EMPTY)
-            pMoves.push_back(Move(pCell,rowColToCell(lR+1,lC+1)));
-    }
-    // Try moving upwards
-    if(mNextPlayer==CELL_WHITE||pKing)
+    pStates.clear();
+
+    MoveList lMoves;
+    generateMoves(lMoves);
+
+    // Convert moves to GameStates
+    for (int i = 0; i < lMoves.size(); ++i)
+    	pStates.push_back(GameState(*this, lMoves[i]));
+}
+
+/**
+ * Returns the cells of the pieces of the player to move that can capture
+ */
+uint32_t GameState::getJumpers() const
+{
+    uint32_t lOwn = getPieces(mNextPlayer);
+    uint32_t lOther = (mRed | mWhite) & ~lOwn;
+    uint32_t lEmpty = ~(mRed | mWhite);
+    int lFirst = mNextPlayer == CELL_RED ? DOWN_LEFT : UP_LEFT;
+    int lLast = lFirst + 1;
+
+    // Find all the pieces that can capture at once: they have an opponent
+    // next to them, with an empty cell behind it
+    uint32_t lJumpers = 0;
+    for (int d = DOWN_LEFT; d <= UP_RIGHT; ++d)
     {
-        // Try moving right
-        if(at(lR-1,lC-1)==CELL_EMPTY)
-            pMoves.push_back(Move(pCell,rowColToCell(lR-1,lC-1)));
-        // Try moving left
-        if(at(lR-1,lC+1)==CELL_EMPTY)
-            pMoves.push_back(Move(pCell,rowColToCell(lR-1,lC+1)));
+        uint32_t lPieces = d >= lFirst && d <= lLast ? lOwn : lOwn & mKings;
+        lJumpers |= lPieces & shift(shift(lEmpty, opposite(d)) & lOther, opposite(d));
     }
+    return lJumpers;
 }
 
 /**
- * Returns a list of all valid moves for \p pWho
+ * Returns the list of all valid moves in this state
  *
- * \param pMoves a vector where the list of moves will be appended
- * \param pWho the \ref ECell code (CELL_OWN or CELL_OTHER) of the
- * player making the move
+ * \param pMoves the list where the moves will be stored (it is cleared first)
  */
-void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
+void GameState::generateMoves(MoveList &pMoves) const
 {
-    pStates.clear();
+    pMoves.clear();
 
     if (mLastMove.isEOG())
     	return;
 
     if (mMovesUntilDraw <= 0)
     {
-    	pStates.push_back(GameState(*this, Move(Move::MOVE_DRAW)));
+    	pMoves.push_back(Move(Move::MOVE_DRAW));
     	return;
     }
 
+    // Men move down the board if red, up the board if white, kings both ways
+    uint32_t lOwn = getPieces(mNextPlayer);
+    uint32_t lOther = (mRed | mWhite) & ~lOwn;
+    uint32_t lEmpty = ~(mRed | mWhite);
+    int lFirst = mNextPlayer == CELL_RED ? DOWN_LEFT : UP_LEFT;
+    int lLast = lFirst + 1;
+
+    uint32_t lJumpers = getJumpers();
+
     // Normal moves are forbidden if any jump is found
-    bool lFound=false;
-    int lPieces[cPlayerPieces];
-    uint8_t lMoveBuffer[cPlayerPieces];
-	std::vector<Move> lMoves;
-    int lNumPieces=0;
-    for (int i = 0; i < cSquares; ++i)
+    if (lJumpers)
     {
-        // Is this a piece which belongs to the player making the move?
-        if (at(i) & mNextPlayer)
+        uint8_t lMoveBuffer[Move::cMaxLength];
+        for (; lJumpers; lJumpers &= lJumpers - 1)
         {
-            bool lIsKing = at(i)&CELL_KING;
-
-            if (tryJump(lMoves, cellToRow(i), cellToCol(i), lIsKing, lMoveBuffer))
-                lFound=true;
-
-            lPieces[lNumPieces++]=i;
+            int lCell = lowestBit(lJumpers);
+            if (mKings & cellBit(lCell))
+                expandJumps(pMoves, lCell, lOther, lEmpty | cellBit(lCell), DOWN_LEFT, UP_RIGHT, lMoveBuffer, 0);
+            else
+                expandJumps(pMoves, lCell, lOther, lEmpty | cellBit(lCell), lFirst, lLast, lMoveBuffer, 0);
         }
     }
-
-    // Try normal moves if no jump was found
-    if (!lFound)
+    else
     {
-        for (int k = 0; k < lNumPieces; ++k)
+        for (uint32_t lPieces = lOwn; lPieces; lPieces &= lPieces - 1)
         {
-            int lCell = lPieces[k];
-            bool lIsKing = at(lCell) & CELL_KING;
-            tryMove(lMoves, lCell, lIsKing);
+            int lCell = lowestBit(lPieces);
+            bool lIsKing = mKings & cellBit(lCell);
+            for (int d = lIsKing ? DOWN_LEFT : lFirst; d <= (lIsKing ? UP_RIGHT : lLast); ++d)
+            {
+                uint32_t lTo = shift(cellBit(lCell), d) & lEmpty;
+                if (lTo)
+                    pMoves.push_back(Move(lCell, lowestBit(lTo)));
+            }
         }
     }
 
-    // Convert moves to GameStates
-    for (unsigned i = 0; i < lMoves.size(); ++i)
-    	pStates.push_back(GameState(*this, lMoves[i]));
-
     // Admit loss if no moves can be found
-    if (pStates.size() == 0)
-    	pStates.push_back(GameState(*this, Move(mNextPlayer == CELL_WHITE ? Move::MOVE_RW : Move::Move::MOVE_WW)));
+    if (pMoves.empty())
+    	pMoves.push_back(Move(mNextPlayer == CELL_WHITE ? Move::MOVE_RW : Move::MOVE_WW));
 }
 
 /**
@@ -308,6 +355,8 @@ void GameState::findPossibleMoves(std::vector<GameState> &pStates) const
  */
 void GameState::doMove(const Move &pMove)
 {
+    int lOldBucket = ZobristKeys::drawBucket(mMovesUntilDraw);
+
     if (pMove.isJump())
     {
     	// Row and column of source cell
@@ -322,15 +371,16 @@ void GameState::doMove(const Move &pMove)
             int dc = cellToCol(pMove[i]);
 
             // Move the jumping piece
-            at(pMove[i]) = at(pMove[i-1]);
-            at(pMove[i-1]) = CELL_EMPTY;
+            uint8_t lPiece = at(pMove[i-1]);
+            setCell(pMove[i-1], CELL_EMPTY);
 
             // Promote to king if we should
-            if ((dr==7 && (at(pMove[i])&CELL_RED)) || (dr==0 && (at(pMove[i])&CELL_WHITE)))
-                at(pMove[i])|=CELL_KING;
+            if ((dr==7 && (lPiece&CELL_RED)) || (dr==0 && (lPiece&CELL_WHITE)))
+                lPiece|=CELL_KING;
+            setCell(pMove[i], lPiece);
 
             // Remove the piece being jumped over
-            at(rowColToCell((sr+dr)>>1,(sc+dc)>>1)) = CELL_EMPTY;
+            setCell(rowColToCell((sr+dr)>>1,(sc+dc)>>1), CELL_EMPTY);
 
             // Prepare for next jump
             sr = dr;
@@ -343,17 +393,22 @@ void GameState::doMove(const Move &pMove)
     else if(pMove.isNormal())
     {
     	// Move the piece
-        at(pMove[1]) = at(pMove[0]);
-        at(pMove[0]) = CELL_EMPTY;
+        uint8_t lPiece = at(pMove[0]);
+        setCell(pMove[0], CELL_EMPTY);
 
         // Promote to king if we should
         int lDR=cellToRow(pMove[1]);
-        if ((lDR==7 && (at(pMove[1])&CELL_RED)) || (lDR==0 && (at(pMove[1])&CELL_WHITE)))
-            at(pMove[1]) |= CELL_KING;
+        if ((lDR==7 && (lPiece&CELL_RED)) || (lDR==0 && (lPiece&CELL_WHITE)))
+            lPiece |= CELL_KING;
+        setCell(pMove[1], lPiece);
 
         // Decrease number of moves left until draw
         --mMovesUntilDraw;
     }
+    else if (pMove.isEOG())
+    {
+        mHash ^= cZobrist.mEndOfGame;
+    }
 
     // Remember last move
     mLastMove = pMove;
@@ -361,6 +416,105 @@ void GameState::doMove(const Move &pMove)
     // Swap player
     mNextPlayer = mNextPlayer ^ (CELL_RED | CELL_WHITE);
 
+    mHash ^= cZobrist.mWhiteToMove
+          ^ cZobrist.mDraw[lOldBucket] ^ cZobrist.mDraw[ZobristKeys::drawBucket(mMovesUntilDraw)];
+}
+
+/**
+ * Sets a cell, updating the hash key and the bitboards
+ */
+void GameState::setCell(int pCell, uint8_t pValue)
+{
+    mHash ^= cZobrist.mPiece[pCell][mCell[pCell]] ^ cZobrist.mPiece[pCell][pValue];
+    putCell(pCell, pValue);
+}
+
+/**
+ * Sets a cell, updating the bitboards but not the hash key
+ */
+void GameState::putCell(int pCell, uint8_t pValue)
+{
+    uint32_t lBit = cellBit(pCell);
+    mRed = (pValue & CELL_RED) ? mRed | lBit : mRed & ~lBit;
+    mWhite = (pValue & CELL_WHITE) ? mWhite | lBit : mWhite & ~lBit;
+    mKings = (pValue & CELL_KING) ? mKings | lBit : mKings & ~lBit;
+    mCell[pCell] = pValue;
+}
+
+/**
+ * Computes the bitboards from scratch
+ */
+void GameState::computeBitboards()
+{
+    mRed = mWhite = mKings = 0;
+    for (int i = 0; i < cSquares; ++i)
+        putCell(i, mCell[i]);
+}
+
+/**
+ * Computes the hash key from scratch
+ */
+uint64_t GameState::computeHash() const
+{
+    uint64_t lHash = cZobrist.mDraw[ZobristKeys::drawBucket(mMovesUntilDraw)];
+    for (int i = 0; i < cSquares; ++i)
+        lHash ^= cZobrist.mPiece[i][mCell[i] & 7];
+    if (mNextPlayer == CELL_WHITE)
+        lHash ^= cZobrist.mWhiteToMove;
+    if (mLastMove.isEOG())
+        lHash ^= cZobrist.mEndOfGame;
+    return lHash;
+}
+
+/**
+ * Same as doMove(pMove), but also stores in \p pUndo what undoMove needs to restore the state
+ *
+ * \param pMove the move to perform
+ * \param pUndo where the information to undo the move is stored
+ */
+void GameState::doMove(const Move &pMove, UndoInfo &pUndo)
+{
+    pUndo.mLastMove = mLastMove;
+    pUndo.mMovesUntilDraw = mMovesUntilDraw;
+    pUndo.mHash = mHash;
+
+    if (pMove.isJump() || pMove.isNormal())
+    {
+        pUndo.mPiece = at(pMove[0]);
+
+        // Remember the pieces that are going to be jumped over
+        if (pMove.isJump())
+            for (unsigned i = 1; i < pMove.length(); ++i)
+                pUndo.mCaptured[i-1] = at(jumpedCell(pMove[i-1], pMove[i]));
+    }
+
+    doMove(pMove);
+}
+
+/**
+ * Takes back a move made with doMove(pMove, pUndo)
+ *
+ * \param pMove the move to take back
+ * \param pUndo the information stored by doMove
+ */
+void GameState::undoMove(const Move &pMove, const UndoInfo &pUndo)
+{
+    if (pMove.isJump() || pMove.isNormal())
+    {
+        // The destination is cleared first, since a jump may end where it started
+        putCell(pMove[pMove.length()-1], CELL_EMPTY);
+        putCell(pMove[0], pUndo.mPiece);
+
+        // Jumped over cells are never landing cells, so they can be restored in any order
+        if (pMove.isJump())
+            for (unsigned i = 1; i < pMove.length(); ++i)
+                putCell(jumpedCell(pMove[i-1], pMove[i]), pUndo.mCaptured[i-1]);
+    }
+
+    mMovesUntilDraw = pUndo.mMovesUntilDraw;
+    mLastMove = pUndo.mLastMove;
+    mNextPlayer = mNextPlayer ^ (CELL_RED | CELL_WHITE);
+    mHash = pUndo.mHash;
 }
 
 /**
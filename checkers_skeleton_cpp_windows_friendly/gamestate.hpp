@@ -1,6 +1,7 @@
 #ifndef _CHECKERS_GAMESTATE_HPP_
 #define _CHECKERS_GAMESTATE_HPP_
 
+#include "bitboard.hpp"
 #include "constants.hpp"
 #include "move.hpp"
 #include <stdint.h>
@@ -8,6 +9,7 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace checkers
 {
@@ -68,6 +70,16 @@ public:
 	 */
 	GameState(const std::string &pMessage);
 
+	/**
+	 * Constructs a board from the cells that hold the pieces, with no move made yet
+	 *
+	 * \param pRed the cells holding a red piece
+	 * \param pWhite the cells holding a white piece
+	 * \param pKings the cells holding a king of either player
+	 * \param pNextPlayer the player to move (CELL_RED or CELL_WHITE)
+	 */
+	GameState(uint32_t pRed, uint32_t pWhite, uint32_t pKings, uint8_t pNextPlayer);
+
 	/**
 	 * Constructs a board which is the result of applying move \p pMove to board \p pRH
 	 *
@@ -101,16 +113,6 @@ public:
 	 *
 	 *   (lBoard.At(23)&CELL_KING)
 	 */
-	uint8_t& at(int pPos)
-	{
-		assert(pPos >= 0);
-		assert(pPos < cSquares);
-		return mCell[pPos];
-	}
-
-	/**
-	 * const version of the above function
-	 */
 	const uint8_t& at(int pPos) const
 	{
 		assert(pPos >= 0);
@@ -142,16 +144,6 @@ public:
 		return mCell[pR * 4 + (pC >> 1)];
 	}
 
-private:
-	///private version of above function (allows modifying cells)
-	uint8_t &mutableAt(int pR, int pC) const
-	{
-		//this is a bit ugly, but is useful for the implementation of
-		//findPossibleMoves. It won't affect in single-threaded programs
-		//and you're not allowed to use threads anyway
-		return const_cast<uint8_t&>(mCell[pR * 4 + (pC >> 1)]);
-	}
-
 public:
 
 	///returns the row corresponding to a cell index
@@ -181,32 +173,32 @@ public:
 		return (pRow * 4 + (pCol >> 1));
 	}
 
+	///returns the cell jumped over when jumping from cell \p pFrom to cell \p pTo
+	static int jumpedCell(int pFrom, int pTo)
+	{
+		return rowColToCell((cellToRow(pFrom) + cellToRow(pTo)) >> 1,
+		                    (cellToCol(pFrom) + cellToCol(pTo)) >> 1);
+	}
+
 private:
 	/**
-	 * Tries to make a jump from a certain position of the board
+	 * Appends to \p pMoves every jump sequence that goes on from cell \p pCell
 	 *
-	 * \param pMoves a vector where the valid moves will be inserted
-	 * \param pOther the \ref ECell code corresponding to the player who is not making the move
-	 * \param pR the row of the cell we are moving from
-	 * \param pC the col
-	 * \param pKing true if the moving piece is a king
-	 * \param pBuffer a buffer where the list of jump positions is
-	 * inserted (for multiple jumps)
-	 * \param pDepth the number of multiple jumps before this attempt
-	 */
-	bool tryJump(std::vector<Move> &pMoves, int pR, int pC, bool pKing,
-			uint8_t *pBuffer, int pDepth = 0) const;
-
-	/**
-	 * Tries to make a move from a certain position
+	 * Pieces jumped over are taken off \p pOther and added to \p pEmpty, so
+	 * that a sequence never jumps the same piece twice. The piece does not
+	 * become a king before the sequence ends.
 	 *
-	 * \param pMoves vector where the valid moves will be inserted
-	 * \param pCell the cell where the move is tried from
-	 * \param pOther the \ref ECell code corresponding to the player
-	 * who is not making the move
-	 * \param pKing true if the piece is a king
+	 * \param pMoves the list where the jumps are appended
+	 * \param pCell the cell the piece has reached
+	 * \param pOther the pieces of the player who is not making the move
+	 * \param pEmpty the empty cells, including the cell the piece started from
+	 * \param pFirst the first \ref EDirection the piece may jump in
+	 * \param pLast the last \ref EDirection the piece may jump in
+	 * \param pBuffer the cells reached so far in the sequence
+	 * \param pDepth the number of jumps before this one
 	 */
-	void tryMove(std::vector<Move> &pMoves, int pCell, bool pKing) const;
+	static void expandJumps(MoveList &pMoves, int pCell, uint32_t pOther, uint32_t pEmpty,
+			int pFirst, int pLast, uint8_t *pBuffer, int pDepth);
 
 public:
 	/**
@@ -218,6 +210,37 @@ public:
 	 */
 	void findPossibleMoves(std::vector<GameState> &pMoves) const;
 
+	/**
+	 * Returns the list of all valid moves in this state
+	 *
+	 * The moves are the same, and in the same order, as the ones leading to
+	 * the states returned by findPossibleMoves (including the draw and
+	 * loss moves that end the game), but no state is copied.
+	 *
+	 * \param pMoves the list where the moves will be stored (it is cleared first)
+	 */
+	void generateMoves(MoveList &pMoves) const;
+
+	/**
+	 * Returns the cells of the pieces of the player to move that can capture
+	 *
+	 * Jumps are mandatory, so when it is not 0 every move of the state is a
+	 * jump (unless the game ends in a draw first).
+	 */
+	uint32_t getJumpers() const;
+
+	/**
+	 * Information needed to take back a move performed with doMove
+	 */
+	struct UndoInfo
+	{
+		Move mLastMove;				///< the last move before the move was made
+		uint8_t mMovesUntilDraw;		///< the moves until draw before the move was made
+		uint8_t mPiece;				///< the moving piece, before any promotion
+		uint8_t mCaptured[cPlayerPieces];	///< the pieces jumped over, in order
+		uint64_t mHash;				///< the hash key before the move was made
+	};
+
 	/**
 	 * Transforms the board by performing a move
 	 *
@@ -227,6 +250,23 @@ public:
 	 */
 	void doMove(const Move &pMove);
 
+	/**
+	 * Same as above, but also stores in \p pUndo what undoMove needs to restore the state
+	 *
+	 * \param pMove the move to perform
+	 * \param pUndo where the information to undo the move is stored
+	 */
+	void doMove(const Move &pMove, UndoInfo &pUndo);
+
+	/**
+	 * Takes back a move made with doMove(pMove, pUndo)
+	 *
+	 * Moves must be undone in the reverse order they were made.
+	 * \param pMove the move to take back
+	 * \param pUndo the information stored by doMove
+	 */
+	void undoMove(const Move &pMove, const UndoInfo &pUndo);
+
 	/**
 	 * Convert the board to a human readable string ready to be printed to std::cerr
 	 *
@@ -259,6 +299,36 @@ public:
 		return mMovesUntilDraw;
 	}
 
+	/**
+	 * Returns the 64-bit Zobrist key of the state
+	 *
+	 * The key covers the pieces (and whether they are kings), the player to move,
+	 * the moves until draw (counts far from a draw share a key) and whether the
+	 * game has ended. It is updated incrementally by doMove and undoMove.
+	 */
+	uint64_t getHash() const
+	{
+		return mHash;
+	}
+
+	/**
+	 * Returns the cells holding a piece of \p pPlayer (CELL_RED or CELL_WHITE)
+	 *
+	 * Bit i is set if cell i holds a piece of the player. Like the hash key,
+	 * the bitboards are kept up to date by doMove and undoMove, and the moves
+	 * are generated from them.
+	 */
+	uint32_t getPieces(uint8_t pPlayer) const
+	{
+		return pPlayer == CELL_RED ? mRed : mWhite;
+	}
+
+	///returns the cells holding a king of either player
+	uint32_t getKings() const
+	{
+		return mKings;
+	}
+
 	/// returns true if the movement marks beginning of game
 	bool isBOG() const
 	{
@@ -286,10 +356,26 @@ public:
 	}
 
 private:
+	///sets a cell, updating the hash key and the bitboards
+	void setCell(int pCell, uint8_t pValue);
+
+	///sets a cell, updating the bitboards but not the hash key
+	void putCell(int pCell, uint8_t pValue);
+
+	///computes the bitboards from scratch
+	void computeBitboards();
+
+	///computes the hash key from scratch
+	uint64_t computeHash() const;
+
 	uint8_t mCell[cSquares];
 	uint8_t mMovesUntilDraw;
 	uint8_t mNextPlayer;
 	Move mLastMove;
+	uint64_t mHash;
+	uint32_t mRed;		///< cells holding a red piece
+	uint32_t mWhite;	///< cells holding a white piece
+	uint32_t mKings;	///< cells holding a king
 };
 
 /*namespace checkers*/}
@@ -1,4 +1,5 @@
 #include "player.hpp"
+#include "game_algorithm.h"
 
 #include <stdlib.h>
 #include <iostream>
@@ -10,6 +11,17 @@ int main(int argc, char **argv)
     bool init = false;
     bool verbose = false;
     bool fast = false;
+    bool ponder = false;
+    int threads = 1;
+    std::string clock_name;
+    std::string endgame_path;
+    std::string build_endgame_path;
+    int build_endgame_pieces = 0;
+    std::string book_path;
+    std::string build_book_path;
+    int build_book_plies = 0;
+    int build_book_games = 0;
+    double build_book_seconds = 0;
     for (int i = 1; i < argc; ++i)
     {
         std::string param(argv[i]);
@@ -19,6 +31,30 @@ int main(int argc, char **argv)
             verbose = true;
         else if (param == "fast" || param == "f")
             fast = true;
+        else if (param == "ponder" || param == "p")
+            ponder = true;
+        else if ((param == "hash" || param == "h") && i + 1 < argc)
+            GameAlgorithm::set_hash_size(atoi(argv[++i]));
+        else if ((param == "threads" || param == "t") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if ((param == "clock" || param == "c") && i + 1 < argc && (std::string(argv[i + 1]) == "cpu" || std::string(argv[i + 1]) == "wall"))
+            clock_name = argv[++i];
+        else if ((param == "endgame" || param == "e") && i + 1 < argc)
+            endgame_path = argv[++i];
+        else if (param == "build_endgame" && i + 2 < argc)
+        {
+            build_endgame_pieces = atoi(argv[++i]);
+            build_endgame_path = argv[++i];
+        }
+        else if ((param == "book" || param == "b") && i + 1 < argc)
+            book_path = argv[++i];
+        else if (param == "build_book" && i + 4 < argc)
+        {
+            build_book_plies = atoi(argv[++i]);
+            build_book_games = atoi(argv[++i]);
+            build_book_seconds = atof(argv[++i]);
+            build_book_path = argv[++i];
+        }
         else
         {
             std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
@@ -26,6 +62,50 @@ int main(int argc, char **argv)
         }
     }
 
+    // Solve the endgames, write the database and quit if the parameter "build_endgame" is given
+    if (!build_endgame_path.empty())
+    {
+        if (checkers::EndgameDatabase::generate(build_endgame_path, build_endgame_pieces))
+            return 0;
+        std::cerr << "Cannot build the endgame database '" << build_endgame_path << "' of up to "
+                  << build_endgame_pieces << " pieces" << std::endl;
+        return -1;
+    }
+
+    checkers::EndgameDatabase endgame_database;
+    if (!endgame_path.empty() && !endgame_database.open(endgame_path))
+    {
+        std::cerr << "Cannot open the endgame database '" << endgame_path << "'" << std::endl;
+        return -1;
+    }
+    if (endgame_database.isOpen())
+        GameAlgorithm::set_endgame_database(&endgame_database);
+
+    GameAlgorithm::set_threads(threads);
+    GameAlgorithm::set_verbose(verbose);
+    // CPU time adds up over all threads, so unless told otherwise a threaded
+    // search measures the deadline on the wall clock
+    if (clock_name == "wall" || (clock_name.empty() && threads > 1))
+        checkers::Deadline::useClock(checkers::Deadline::WALL_TIME);
+
+    // Play the opening games, write the book and quit if the parameter "build_book" is given.
+    // The endgame database, if given, is used by the searches.
+    if (!build_book_path.empty())
+    {
+        if (build_book_plies > 0 && build_book_games > 0 && build_book_seconds > 0
+            && checkers::OpeningBook::generate(build_book_path, build_book_plies, build_book_games, build_book_seconds))
+            return 0;
+        std::cerr << "Cannot build the opening book '" << build_book_path << "'" << std::endl;
+        return -1;
+    }
+
+    checkers::OpeningBook book;
+    if (!book_path.empty() && !book.open(book_path))
+    {
+        std::cerr << "Cannot open the opening book '" << book_path << "'" << std::endl;
+        return -1;
+    }
+
     // Start the game by sending the starting board without moves if the parameter "init" is given
     if (init)
     {
@@ -34,7 +114,7 @@ int main(int argc, char **argv)
         std::cout << message << std::endl;
     }
 
-    checkers::Player player;
+    checkers::Player player(book.isOpen() ? &book : NULL);
 
     std::string input_message;
     while (std::getline(std::cin, input_message))
@@ -87,6 +167,10 @@ int main(int argc, char **argv)
         //std::cerr << "Sending: '" << output_message << "'"<< std::endl;
         std::cout << output_message << std::endl;
 
+        // Think on the opponent's time, while waiting for its move
+        if (ponder && !output_state.getMove().isEOG())
+            GameAlgorithm::start_pondering(output_state);
+
         // Quit if this is end of game
         if (output_state.getMove().isEOG())
             break;
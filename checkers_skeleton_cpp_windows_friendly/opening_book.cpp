@@ -0,0 +1,137 @@
+#include "opening_book.hpp"
+#include "game_algorithm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace checkers
+{
+
+const char OpeningBook::cMagic[8] = { 'C', 'K', 'R', 'S', 'B', 'O', 'O', 'K' };
+
+///returns the index of \p pMove in \p pMoves, or -1 if it is not there
+static int findMove(const Move &pMove, const MoveList &pMoves)
+{
+	for (int i = 0; i < pMoves.size(); ++i)
+		if (pMoves[i] == pMove)
+			return i;
+	return -1;
+}
+
+bool OpeningBook::generate(const std::string &pPath, int pPlies, int pGames, double pSeconds)
+{
+	Deadline lStart = Deadline::now();
+
+	// The move found for each position searched so far. A position reached again
+	// in a later game is not searched again. The random moves that make the
+	// games branch off are not part of the book.
+	std::map<uint64_t, int> lSearched;
+	std::mt19937 lRandom(1);
+	for (int g = 0; g < pGames; ++g)
+	{
+		int lBranch = g == 0 ? -1 : (int)(lRandom() % pPlies);
+		GameState lState;
+		MoveList lMoves;
+		for (int lPly = 0; lPly < pPlies && !lState.isEOG(); ++lPly)
+		{
+			lState.generateMoves(lMoves);
+			if (lPly == lBranch)
+			{
+				lState.doMove(lMoves[(int)(lRandom() % lMoves.size())]);
+				continue;
+			}
+
+			std::map<uint64_t, int>::const_iterator lFound = lSearched.find(lState.getHash());
+			int lBest;
+			if (lFound != lSearched.end())
+				lBest = lFound->second;
+			else
+			{
+				// The table holds values for the side the search played, and
+				// consecutive positions are for opposite sides, so every search
+				// starts from an empty table
+				GameAlgorithm::new_game();
+				lBest = findMove(GameAlgorithm::get_best_move(Deadline::now() + pSeconds, lState).getMove(), lMoves);
+				assert(lBest >= 0);
+				lSearched[lState.getHash()] = lBest;
+			}
+			lState.doMove(lMoves[lBest]);
+		}
+		std::cerr << "book:game:" << g + 1 << ":positions:" << lSearched.size() << std::endl;
+	}
+
+	std::vector<Entry> lEntries;
+	for (std::map<uint64_t, int>::const_iterator it = lSearched.begin(); it != lSearched.end(); ++it)
+	{
+		Entry lEntry;
+		std::memset(&lEntry, 0, sizeof(lEntry));
+		lEntry.mKey = it->first;
+		lEntry.mMove = (uint8_t)it->second;
+		lEntries.push_back(lEntry);
+	}
+
+	Header lHeader;
+	std::memset(&lHeader, 0, sizeof(lHeader));
+	std::memcpy(lHeader.mMagic, cMagic, sizeof(cMagic));
+	lHeader.mVersion = cVersion;
+	lHeader.mPlies = (uint32_t)pPlies;
+	lHeader.mCount = (uint32_t)lEntries.size();
+
+	std::ofstream lFile(pPath.c_str(), std::ios::binary | std::ios::trunc);
+	lFile.write(reinterpret_cast<const char*>(&lHeader), sizeof(lHeader));
+	if (!lEntries.empty())
+		lFile.write(reinterpret_cast<const char*>(&lEntries[0]), lEntries.size() * sizeof(Entry));
+	lFile.close();
+	if (!lFile)
+		return false;
+
+	std::cerr << "book:" << lEntries.size() << " positions:time:" << Deadline::now() - lStart << std::endl;
+	return true;
+}
+
+bool OpeningBook::open(const std::string &pPath)
+{
+	mEntries = NULL;
+	mCount = 0;
+	if (!mFile.open(pPath))
+		return false;
+
+	Header lHeader;
+	if (mFile.size() < sizeof(lHeader))
+		return false;
+	std::memcpy(&lHeader, mFile.data(), sizeof(lHeader));
+	if (std::memcmp(lHeader.mMagic, cMagic, sizeof(cMagic)) != 0 || lHeader.mVersion != cVersion
+		|| lHeader.mCount == 0 || mFile.size() != sizeof(lHeader) + (std::size_t)lHeader.mCount * sizeof(Entry))
+	{
+		mFile.close();
+		return false;
+	}
+
+	mEntries = reinterpret_cast<const Entry*>(mFile.data() + sizeof(lHeader));
+	mCount = lHeader.mCount;
+	return true;
+}
+
+bool OpeningBook::probe(const GameState &pState, Move &pMove) const
+{
+	if (!mEntries || pState.isEOG())
+		return false;
+
+	uint64_t lKey = pState.getHash();
+	const Entry *lEntry = std::lower_bound(mEntries, mEntries + mCount, lKey, keyBefore);
+	if (lEntry == mEntries + mCount || lEntry->mKey != lKey)
+		return false;
+
+	MoveList lMoves;
+	pState.generateMoves(lMoves);
+	if (lEntry->mMove >= lMoves.size())
+		return false;
+	pMove = lMoves[lEntry->mMove];
+	return true;
+}
+
+/*namespace checkers*/ }
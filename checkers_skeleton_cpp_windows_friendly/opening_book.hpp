@@ -0,0 +1,80 @@
+#ifndef _CHECKERS_OPENING_BOOK_HPP_
+#define _CHECKERS_OPENING_BOOK_HPP_
+
+#include "gamestate.hpp"
+#include "../common/mapped_file.hpp"
+#include <stdint.h>
+#include <string>
+
+namespace checkers {
+
+/**
+ * The moves to play in the first plies of the game, learnt by self-play
+ *
+ * generate() plays games against itself from the starting board, choosing
+ * every move of the first plies with a long search, and in each game but the
+ * first one random move at a random ply, so that the games branch off the
+ * main line. A position is searched the first time a game reaches it, and the
+ * games that reach it again play the same move, so the book holds one move per
+ * position. open() maps such a file, and probe() looks a position up in it.
+ *
+ * The file is a Header followed by the entries sorted by key (see
+ * GameState::getHash()), so a probe is a binary search. A move is stored as
+ * its index in the order GameState::generateMoves() lists the moves, like in
+ * the transposition table. Numbers are stored in the byte order of the
+ * machine that generated the file.
+ */
+class OpeningBook
+{
+public:
+    OpeningBook()
+        :   mEntries(NULL)
+        ,   mCount(0)
+    {
+    }
+
+    ///plays \p pGames games of \p pPlies plies with searches of \p pSeconds and
+    ///writes the book to \p pPath, returns false if the file cannot be written
+    static bool generate(const std::string &pPath, int pPlies, int pGames, double pSeconds);
+
+    ///maps the book at \p pPath, returns false if it is missing or invalid
+    bool open(const std::string &pPath);
+
+    ///returns true while a book is mapped
+    bool isOpen() const    {    return mEntries != NULL;    }
+
+    ///looks up \p pState and sets \p pMove to the move to play, returns false
+    ///if the position is not in the book
+    bool probe(const GameState &pState, Move &pMove) const;
+
+private:
+    struct Header
+    {
+        char mMagic[8];         ///< cMagic
+        uint32_t mVersion;      ///< cVersion
+        uint32_t mPlies;        ///< the positions are in the first mPlies plies
+        uint32_t mCount;        ///< the number of entries
+        uint32_t mReserved;
+    };
+
+    struct Entry
+    {
+        uint64_t mKey;          ///< the hash key of the position
+        uint8_t mMove;          ///< the index of the move
+        uint8_t mReserved[7];
+    };
+
+    static const char cMagic[8];
+    static const uint32_t cVersion = 2;
+
+    ///orders the entries by key
+    static bool keyBefore(const Entry &pEntry, uint64_t pKey)    {    return pEntry.mKey < pKey;    }
+
+    common::MappedFile mFile;
+    const Entry *mEntries;
+    uint32_t mCount;
+};
+
+/*namespace checkers*/ }
+
+#endif
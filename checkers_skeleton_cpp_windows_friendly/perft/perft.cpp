@@ -0,0 +1,355 @@
+#include "../gamestate.hpp"
+#include "../../common/deadline.hpp"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Counts the positions reached after a number of moves (perft)
+ *
+ * The counts of the starting board are known (7, 49, 302, 1469, 7361, ...),
+ * so they check the move generator, and the time they take measures it. The
+ * moves that end the game (a player without moves loses, and the draw after
+ * GameState::cMovesUntilDraw moves without capture) are not counted. At the
+ * last ply the moves are counted without being made, unless checking.
+ *
+ * With the parameter check, the moves of every position are also compared with
+ * those of ReferenceBoard, a slow generator written apart from GameState, and
+ * every move is made with doMove, compared with the reference board, and taken
+ * back with undoMove.
+ */
+
+namespace checkers {
+
+///set by checkMoves() when a check fails
+static std::atomic<bool> sFailed(false);
+
+///reports that \p pWhat went wrong in \p pState
+static void fail(const GameState &pState, const std::string &pWhat)
+{
+    sFailed = true;
+    std::cerr << "*** ERROR! *** " << pWhat << " in '" << pState.toMessage() << "'" << std::endl;
+}
+
+/**
+ * The board and move generator of the original client
+ *
+ * The pieces are read from a GameState square by square, and the moves are
+ * found by trying every direction from every square, jumps recursively like
+ * the original tryJump(). It is slow, but it shares no code with
+ * GameState::generateMoves() and doMove(), so it can check them.
+ */
+class ReferenceBoard
+{
+public:
+    explicit ReferenceBoard(const GameState &pState)
+        :   mPlayer(pState.getNextPlayer())
+    {
+        for (int r = 0; r < 8; ++r)
+            for (int c = 0; c < 8; ++c)
+                mCell[r][c] = pState.at(r, c);
+    }
+
+    ///returns the moves of the player to move, jumps only if there are any,
+    ///as strings sorted so that lists can be compared whatever their order
+    std::vector<std::string> findMoves()
+    {
+        std::vector<Move> lMoves;
+        uint8_t lBuffer[Move::cMaxLength];
+        for (int r = 0; r < 8; ++r)
+            for (int c = 0; c < 8; ++c)
+                if (mCell[r][c] != CELL_INVALID && (mCell[r][c] & mPlayer))
+                    tryJump(lMoves, r, c, mCell[r][c] & CELL_KING, lBuffer, 0);
+        if (lMoves.empty())
+        {
+            for (int r = 0; r < 8; ++r)
+                for (int c = 0; c < 8; ++c)
+                    if (mCell[r][c] != CELL_INVALID && (mCell[r][c] & mPlayer))
+                        for (int d = 0; d < 4; ++d)
+                            if (canGo(mCell[r][c], d) && at(r + cRow[d], c + cCol[d]) == CELL_EMPTY)
+                                lMoves.push_back(Move(GameState::rowColToCell(r, c), GameState::rowColToCell(r + cRow[d], c + cCol[d])));
+        }
+
+        std::vector<std::string> lStrings;
+        for (size_t i = 0; i < lMoves.size(); ++i)
+            lStrings.push_back(lMoves[i].toString());
+        std::sort(lStrings.begin(), lStrings.end());
+        return lStrings;
+    }
+
+    ///plays \p pMove, which must be one of the moves found
+    void play(const Move &pMove)
+    {
+        int lFrom = pMove[0];
+        uint8_t lPiece = cell(lFrom);
+        cell(lFrom) = CELL_EMPTY;
+        if (pMove.isJump())
+            for (unsigned i = 1; i < pMove.length(); ++i)
+                cell(GameState::jumpedCell(pMove[i - 1], pMove[i])) = CELL_EMPTY;
+        int lTo = pMove[pMove.length() - 1];
+        int lRow = GameState::cellToRow(lTo);
+        if ((lRow == 7 && (lPiece & CELL_RED)) || (lRow == 0 && (lPiece & CELL_WHITE)))
+            lPiece |= CELL_KING;
+        cell(lTo) = lPiece;
+        mPlayer ^= CELL_RED | CELL_WHITE;
+    }
+
+    ///returns true if \p pState has the same pieces and player to move
+    bool matches(const GameState &pState) const
+    {
+        if (pState.getNextPlayer() != mPlayer)
+            return false;
+        for (int r = 0; r < 8; ++r)
+            for (int c = 0; c < 8; ++c)
+                if (pState.at(r, c) != mCell[r][c])
+                    return false;
+        return true;
+    }
+
+private:
+    ///the directions: down left, down right, up left, up right
+    static const int cRow[4];
+    static const int cCol[4];
+
+    uint8_t at(int pR, int pC) const
+    {
+        return pR < 0 || pR > 7 || pC < 0 || pC > 7 ? (uint8_t)CELL_INVALID : mCell[pR][pC];
+    }
+
+    uint8_t &cell(int pCell)    {    return mCell[GameState::cellToRow(pCell)][GameState::cellToCol(pCell)];    }
+
+    ///returns true if \p pPiece may move in direction \p pDirection: red men
+    ///down, white men up, kings both ways
+    static bool canGo(uint8_t pPiece, int pDirection)
+    {
+        return (pPiece & CELL_KING) || (pDirection < 2 ? (pPiece & CELL_RED) : (pPiece & CELL_WHITE));
+    }
+
+    ///adds the jumps on from (\p pR, \p pC), the \p pDepth cells jumped to so far
+    ///being in \p pBuffer, returns true if a jump was found
+    bool tryJump(std::vector<Move> &pMoves, int pR, int pC, bool pKing, uint8_t *pBuffer, int pDepth)
+    {
+        uint8_t lSelf = mCell[pR][pC];
+        mCell[pR][pC] = CELL_EMPTY;
+        pBuffer[pDepth] = (uint8_t)GameState::rowColToCell(pR, pC);
+
+        bool lFound = false;
+        uint8_t lOther = mPlayer ^ (CELL_RED | CELL_WHITE);
+        uint8_t lPiece = pKing ? (uint8_t)(mPlayer | CELL_KING) : mPlayer;
+        for (int d = 0; d < 4; ++d)
+        {
+            int lR = pR + cRow[d];
+            int lC = pC + cCol[d];
+            uint8_t lJumped = at(lR, lC);
+            if (!canGo(lPiece, d) || lJumped == CELL_INVALID || !(lJumped & lOther) || at(lR + cRow[d], lC + cCol[d]) != CELL_EMPTY)
+                continue;
+            lFound = true;
+            mCell[lR][lC] = CELL_EMPTY;
+            tryJump(pMoves, lR + cRow[d], lC + cCol[d], pKing, pBuffer, pDepth + 1);
+            mCell[lR][lC] = lJumped;
+        }
+
+        mCell[pR][pC] = lSelf;
+        if (!lFound && pDepth > 0)
+            pMoves.push_back(Move(pBuffer, pDepth + 1));
+        return lFound;
+    }
+
+    uint8_t mCell[8][8];
+    uint8_t mPlayer;
+};
+
+const int ReferenceBoard::cRow[4] = { 1, 1, -1, -1 };
+const int ReferenceBoard::cCol[4] = { -1, 1, -1, 1 };
+
+///compares \p pMoves, the moves generated in \p pState, and the positions
+///doMove() reaches with them, with ReferenceBoard, and checks that undoMove()
+///restores the position and its hash key
+static void checkMoves(GameState &pState, const MoveList &pMoves)
+{
+    std::string lMessage = pState.toMessage();
+    uint64_t lHash = pState.getHash();
+    if (GameState(lMessage).getHash() != lHash)
+        fail(pState, "wrong hash key");
+    if (pState.getMovesUntilDraw() <= 0)
+    {
+        if (pMoves.size() != 1 || !(pMoves[0] == Move(Move::MOVE_DRAW)))
+            fail(pState, "no draw after the moves without capture");
+        return;
+    }
+
+    std::vector<std::string> lExpected = ReferenceBoard(pState).findMoves();
+    if (lExpected.empty())
+    {
+        Move lLoss(pState.getNextPlayer() == CELL_WHITE ? Move::MOVE_RW : Move::MOVE_WW);
+        if (pMoves.size() != 1 || !(pMoves[0] == lLoss))
+            fail(pState, "no loss for the player without moves");
+        return;
+    }
+    std::vector<std::string> lGenerated;
+    for (int i = 0; i < pMoves.size(); ++i)
+        lGenerated.push_back(pMoves[i].toString());
+    std::sort(lGenerated.begin(), lGenerated.end());
+    if (lGenerated != lExpected)
+    {
+        fail(pState, "generateMoves differs from the reference moves");
+        return;
+    }
+
+    GameState::UndoInfo lUndo;
+    for (int i = 0; i < pMoves.size(); ++i)
+    {
+        ReferenceBoard lReference(pState);
+        lReference.play(pMoves[i]);
+        pState.doMove(pMoves[i], lUndo);
+        if (!lReference.matches(pState))
+            fail(pState, "doMove " + pMoves[i].toString() + " differs from the reference board");
+        pState.undoMove(pMoves[i], lUndo);
+        if (pState.toMessage() != lMessage || pState.getHash() != lHash)
+            fail(pState, "undoMove does not restore the state before " + pMoves[i].toString());
+    }
+}
+
+///returns the number of positions \p pDepth moves after \p pState
+static uint64_t perft(GameState &pState, int pDepth, bool pCheck)
+{
+    MoveList lMoves;
+    pState.generateMoves(lMoves);
+    if (pCheck)
+        checkMoves(pState, lMoves);
+    if (lMoves.empty() || lMoves[0].isEOG())
+        return 0;
+    if (pDepth == 1)
+        return lMoves.size();
+
+    uint64_t lCount = 0;
+    GameState::UndoInfo lUndo;
+    for (int i = 0; i < lMoves.size(); ++i)
+    {
+        pState.doMove(lMoves[i], lUndo);
+        lCount += perft(pState, pDepth - 1, pCheck);
+        pState.undoMove(lMoves[i], lUndo);
+    }
+    return lCount;
+}
+
+///counts the positions \p pDepth moves after each root move of \p pState in
+///\p pCounts, the root moves being shared out among \p pThreads threads
+static void perftRoot(const GameState &pState, int pDepth, bool pCheck, int pThreads,
+                      MoveList &pMoves, std::vector<uint64_t> &pCounts)
+{
+    GameState lRoot = pState;
+    lRoot.generateMoves(pMoves);
+    if (pCheck)
+        checkMoves(lRoot, pMoves);
+    if (!pMoves.empty() && pMoves[0].isEOG())
+        pMoves.clear();
+    pCounts.assign(pMoves.size(), 0);
+
+    std::atomic<int> lNext(0);
+    std::vector<std::thread> lThreads;
+    for (int t = 0; t < std::min(pThreads, pMoves.size()); ++t)
+    {
+        lThreads.push_back(std::thread([&]()
+        {
+            for (int i = lNext++; i < pMoves.size(); i = lNext++)
+            {
+                GameState lState = pState;
+                lState.doMove(pMoves[i]);
+                pCounts[i] = pDepth == 1 ? 1 : perft(lState, pDepth - 1, pCheck);
+            }
+        }));
+    }
+    for (size_t t = 0; t < lThreads.size(); ++t)
+        lThreads[t].join();
+}
+
+/*namespace checkers*/ }
+
+using namespace checkers;
+
+int main(int argc, char **argv)
+{
+    // Parse parameters
+    int depth = 0;
+    int threads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+    bool divide = false;
+    bool check = false;
+    std::vector<GameState> positions;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string param(argv[i]);
+        if ((param == "depth" || param == "d") && i + 1 < argc)
+            depth = atoi(argv[++i]);
+        else if ((param == "threads" || param == "t") && i + 1 < argc)
+            threads = std::max(atoi(argv[++i]), 1);
+        else if (param == "divide")
+            divide = true;
+        else if (param == "check")
+            check = true;
+        else if ((param == "position" || param == "p") && i + 1 < argc)
+            positions.push_back(GameState(std::string(argv[++i])));
+        else if (param == "stdin")
+        {
+            std::string message;
+            while (std::getline(std::cin, message))
+                if (!message.empty())
+                    positions.push_back(GameState(message));
+        }
+        else
+        {
+            std::cerr << "Unknown parameter: '" << argv[i] << "'" << std::endl;
+            return -1;
+        }
+    }
+    if (depth <= 0)
+    {
+        std::cerr << "Usage: perft depth N [threads T] [divide] [check] [position MESSAGE]... [stdin]" << std::endl;
+        return -1;
+    }
+    if (positions.empty())
+        positions.push_back(GameState());
+
+    // Every depth up to the one asked for, and its root moves with divide
+    uint64_t total_nodes = 0;
+    double total_time = 0;
+    for (size_t p = 0; p < positions.size(); ++p)
+    {
+        std::cout << "position '" << positions[p].toMessage() << "'" << std::endl;
+        for (int d = 1; d <= depth; ++d)
+        {
+            int64_t start = get_wall_time();
+            MoveList moves;
+            std::vector<uint64_t> counts;
+            perftRoot(positions[p], d, check, threads, moves, counts);
+            double elapsed = (get_wall_time() - start) * 1e-9;
+
+            uint64_t nodes = 0;
+            for (size_t i = 0; i < counts.size(); ++i)
+                nodes += counts[i];
+            total_nodes += nodes;
+            total_time += elapsed;
+            std::cout << "depth " << d << " nodes " << nodes << " time " << std::fixed << std::setprecision(3) << elapsed
+                      << " moves/s " << (long)(elapsed > 0 ? nodes / elapsed : 0) << std::endl;
+
+            if (divide && d == depth)
+                for (int i = 0; i < moves.size(); ++i)
+                    std::cout << "  " << moves[i].toString() << " " << counts[i] << std::endl;
+        }
+    }
+    std::cout << "total nodes " << total_nodes << " time " << std::setprecision(3) << total_time
+              << " moves/s " << (long)(total_time > 0 ? total_nodes / total_time : 0) << std::endl;
+
+    if (sFailed)
+    {
+        std::cerr << "Move generation checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# Counts the positions up to a depth from the starting board or given ones, e.g.
+#   ./run.sh depth 10
+#   ./run.sh depth 6 divide check position "MESSAGE"
+# See perft.cpp for the other parameters.
+
+cd "$(dirname "$0")"
+if g++ -O2 perft.cpp $(ls ../*.cpp | grep -v '/main.cpp$') -Wall -std=c++11 -pthread -o perft.exe;
+then
+    ./perft.exe "$@"
+else
+    echo "Compilation failed."
+fi
@@ -19,6 +19,15 @@ GameState Player::play(const GameState &pState,const Deadline &pDue)
      * Here you should write your clever algorithms to get the best next move, ie the best
      * next state. This skeleton returns a random move instead.
      */
+
+    // The opening moves were chosen by long searches before the game
+    Move lBookMove;
+    if (mBook && mBook->probe(pState, lBookMove))
+    {
+        std::cerr << "book:" << lBookMove.toMessage() << std::endl;
+        return GameState(pState, lBookMove);
+    }
+
     return GameAlgorithm::get_best_move(pDue, pState);
 }
 
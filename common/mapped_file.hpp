@@ -0,0 +1,109 @@
+#ifndef _COMMON_MAPPED_FILE_HPP_
+#define _COMMON_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace common {
+
+/**
+ * A file mapped read-only into memory
+ *
+ * The pages are only read from disk when they are first touched and are
+ * shared by every process that maps the same file, so opening a large
+ * database costs nothing until it is probed.
+ */
+class MappedFile
+{
+public:
+    MappedFile()
+        :   mData(NULL)
+        ,   mSize(0)
+    {
+    }
+
+    ~MappedFile()    {    close();    }
+
+    ///maps the file at \p pPath, returns false if it cannot be opened or is empty
+    bool open(const std::string &pPath)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE lFile = CreateFileA(pPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (lFile == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER lSize;
+        HANDLE lMapping = NULL;
+        if (GetFileSizeEx(lFile, &lSize) && lSize.QuadPart > 0)
+            lMapping = CreateFileMappingA(lFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(lFile);
+        if (!lMapping)
+            return false;
+        mData = static_cast<const char*>(MapViewOfFile(lMapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(lMapping);
+        if (!mData)
+            return false;
+        mSize = (std::size_t)lSize.QuadPart;
+#else
+        int lFile = ::open(pPath.c_str(), O_RDONLY);
+        if (lFile < 0)
+            return false;
+        struct stat lStat;
+        void *lData = MAP_FAILED;
+        if (fstat(lFile, &lStat) == 0 && lStat.st_size > 0)
+            lData = mmap(NULL, (std::size_t)lStat.st_size, PROT_READ, MAP_SHARED, lFile, 0);
+        ::close(lFile);
+        if (lData == MAP_FAILED)
+            return false;
+        mData = static_cast<const char*>(lData);
+        mSize = (std::size_t)lStat.st_size;
+#endif
+        return true;
+    }
+
+    ///unmaps the file
+    void close()
+    {
+        if (!mData)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(const_cast<char*>(mData), mSize);
+#endif
+        mData = NULL;
+        mSize = 0;
+    }
+
+    ///returns true while a file is mapped
+    bool isOpen() const    {    return mData != NULL;    }
+
+    ///returns the contents of the file
+    const char *data() const    {    return mData;    }
+
+    ///returns the size of the file in bytes
+    std::size_t size() const    {    return mSize;    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+
+    const char *mData;
+    std::size_t mSize;
+};
+
+/*namespace common*/ }
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef _COMMON_MOVE_ORDERING_HPP_
+#define _COMMON_MOVE_ORDERING_HPP_
+
+#include <stdint.h>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace common {
+
+/**
+ * Orders the moves of the nodes of an alpha-beta search
+ *
+ * The moves of a node are tried in this order:
+ *  - the hash move, the best move found by an earlier search of the position
+ *  - moves that end the game, then captures, the most pieces first
+ *  - the two killer moves of the ply: the last moves that caused a cutoff at
+ *    the same distance from the root
+ *  - the other moves, by their history score, which grows every time a move
+ *    causes a cutoff, the more so the deeper the search below it
+ *
+ * Moves are told apart by Move::getKey(), so a killer or history score applies
+ * to every move with the same key. Each search thread has its own MoveOrdering.
+ *
+ * \p Move must provide getKey(), a number below Move::cNumKeys, getType(),
+ * which is above Move::MOVE_NORMAL for captures, and isEOG(). \p MoveList must
+ * provide size(), operator[] and MoveList::cCapacity.
+ */
+template <class Move, class MoveList>
+class MoveOrdering
+{
+public:
+    static const int cMaxPly = 128;
+    static const int cNumKillers = 2;
+
+    MoveOrdering()
+        :   mSearch(0)
+    {
+        std::memset(mHistory, 0, sizeof(mHistory));
+        clearKillers();
+    }
+
+    ///prepares for search number \p pSearch: the killers of the previous search
+    ///are forgotten and its history scores halved. Calling it again with the
+    ///same number does nothing, so each thread can call it whenever it starts
+    ///working on a search.
+    void startSearch(unsigned pSearch)
+    {
+        if (pSearch == mSearch)
+            return;
+        mSearch = pSearch;
+        clearKillers();
+        ageHistory();
+    }
+
+    ///records that \p pMove, played by \p pPlayer \p pPly plies from the root,
+    ///caused a cutoff with \p pDepth plies left to search
+    void cutoff(const Move &pMove, int pPly, uint8_t pPlayer, int pDepth)
+    {
+        int lKey = pMove.getKey();
+        if (pPly < cMaxPly && mKillers[pPly][0] != lKey)
+        {
+            mKillers[pPly][1] = mKillers[pPly][0];
+            mKillers[pPly][0] = lKey;
+        }
+
+        int &lHistory = mHistory[side(pPlayer)][lKey];
+        lHistory += pDepth * pDepth;
+        if (lHistory > cMaxHistory)
+            ageHistory();
+    }
+
+    ///returns how early \p pMove should be tried, the higher the earlier
+    int score(const Move &pMove, int pPly, uint8_t pPlayer) const
+    {
+        int lKey = pMove.getKey();
+        int lScore = mHistory[side(pPlayer)][lKey];
+        if (pMove.isEOG())
+            lScore += cWinScore;
+        else if (pMove.getType() > Move::MOVE_NORMAL)
+            lScore += pMove.getType() * cCaptureScore;
+        if (pPly < cMaxPly)
+        {
+            if (mKillers[pPly][0] == lKey)
+                lScore += cKillerScore;
+            else if (mKillers[pPly][1] == lKey)
+                lScore += cKillerScore - 1;
+        }
+        return lScore;
+    }
+
+    /**
+     * Hands out the moves of a node in the order they should be tried
+     *
+     * The hash move is handed out first without looking at the other moves, so
+     * nothing is scored when it causes a cutoff. After it, the best scored move
+     * left is picked each time, the first generated one on ties.
+     */
+    class Picker
+    {
+    public:
+        ///orders \p pMoves, the moves of \p pPlayer \p pPly plies from the root.
+        ///\p pHashMove is the index of the move to try first, or -1
+        Picker(const MoveOrdering &pOrdering, const MoveList &pMoves, int pPly, uint8_t pPlayer, int pHashMove = -1)
+            :   mOrdering(pOrdering)
+            ,   mMoves(pMoves)
+            ,   mPly(pPly)
+            ,   mPlayer(pPlayer)
+            ,   mHashMove(pHashMove >= 0 && pHashMove < pMoves.size() ? pHashMove : -1)
+            ,   mStage(HASH_MOVE)
+            ,   mCount(0)
+            ,   mNext(0)
+        {
+        }
+
+        ///returns the index in the list of the next move to try, or -1 once
+        ///every move has been handed out
+        int next()
+        {
+            if (mStage == HASH_MOVE)
+            {
+                mStage = SCORE_MOVES;
+                if (mHashMove >= 0)
+                    return mHashMove;
+            }
+            if (mStage == SCORE_MOVES)
+            {
+                mStage = PICK_MOVES;
+                scoreMoves();
+            }
+            if (mNext == mCount)
+                return -1;
+
+            int lBest = mNext;
+            for (int i = mNext + 1; i < mCount; ++i)
+                if (mScores[i] > mScores[lBest])
+                    lBest = i;
+            std::swap(mScores[mNext], mScores[lBest]);
+            std::swap(mIndices[mNext], mIndices[lBest]);
+            return mIndices[mNext++];
+        }
+
+    private:
+        enum EStage
+        {
+            HASH_MOVE,      ///< the hash move comes next
+            SCORE_MOVES,    ///< the other moves must be scored
+            PICK_MOVES      ///< the other moves are being handed out
+        };
+
+        void scoreMoves()
+        {
+            for (int i = 0; i < mMoves.size(); ++i)
+            {
+                if (i == mHashMove)
+                    continue;
+                mIndices[mCount] = (uint8_t)i;
+                mScores[mCount++] = mOrdering.score(mMoves[i], mPly, mPlayer);
+            }
+        }
+
+        const MoveOrdering &mOrdering;
+        const MoveList &mMoves;
+        int mPly;
+        uint8_t mPlayer;
+        int mHashMove;
+        EStage mStage;
+        int mCount;     ///< number of scored moves
+        int mNext;      ///< the next scored move to hand out
+        int mScores[MoveList::cCapacity];
+        uint8_t mIndices[MoveList::cCapacity];
+    };
+
+private:
+    static const int cMaxHistory = 1 << 16;
+    static const int cKillerScore = 1 << 20;
+    static const int cCaptureScore = 1 << 22;
+    static const int cWinScore = 1 << 28;
+
+    ///the players are the Cell codes 1 and 2
+    static int side(uint8_t pPlayer)
+    {
+        assert(pPlayer == 1 || pPlayer == 2);
+        return pPlayer - 1;
+    }
+
+    void clearKillers()
+    {
+        for (int i = 0; i < cMaxPly; ++i)
+            for (int j = 0; j < cNumKillers; ++j)
+                mKillers[i][j] = -1;
+    }
+
+    void ageHistory()
+    {
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < Move::cNumKeys; ++j)
+                mHistory[i][j] /= 2;
+    }
+
+    unsigned mSearch;
+    int mKillers[cMaxPly][cNumKillers];
+    int mHistory[2][Move::cNumKeys];
+};
+
+/*namespace common*/ }
+
+#endif
@@ -0,0 +1,594 @@
+#ifndef _COMMON_SEARCH_HPP_
+#define _COMMON_SEARCH_HPP_
+
+#include "deadline.hpp"
+#include "move_ordering.hpp"
+#include "search_control.hpp"
+#include "thread_pool.hpp"
+#include "transposition_table.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace common {
+
+/**
+ * The alpha-beta search shared by the games
+ *
+ * A negamax search with iterative deepening, aspiration windows, principal
+ * variation search, a transposition table, move ordering (previous principal
+ * variation, hash move, captures, killers and history) and the root moves
+ * shared out among several threads. Everything that depends on the game comes
+ * from \p Game, a traits class that provides:
+ *
+ *  - the types State, Move, MoveList and Value (int or float). Move and
+ *    MoveList must suit MoveOrdering, and State must provide
+ *    generateMoves(MoveList&), doMove(const Move&, State::UndoInfo&),
+ *    undoMove(const Move&, const State::UndoInfo&), isEOG(), getNextPlayer(),
+ *    getMove() and toMessage().
+ *  - Value evaluate(const State&, uint8_t pOurPlayer): the value of a position
+ *    for the player the search is run for
+ *  - bool isDecided(Value): true for the values of won, lost and drawn games
+ *  - bool probe(const State&, uint8_t pOurPlayer, Value &pValue): true if the
+ *    value of the position is known without a search, e.g. from an endgame
+ *    database, with the value for the player the search is run for
+ *  - bool isQuiet(const State&): false while the position must be searched
+ *    further at the horizon, e.g. while a capture is pending
+ *  - uint64_t key(const State&, int &pSymmetry): the transposition table key,
+ *    and the symmetry that maps the position to the one the key stands for
+ *    (0 for games without symmetric keys)
+ *  - int packMove(const MoveList&, int pIndex, int pSymmetry) and
+ *    int unpackMove(const MoveList&, int pPacked, int pSymmetry): turn the
+ *    index of a move into the byte stored in the table and back (-1 if the
+ *    move is not in the list)
+ *  - void pruneRootMoves(State&, MoveList&): removes root moves that need not
+ *    be searched, e.g. moves to symmetric positions
+ *  - int maxDepth(const State&): the deepest iteration worth searching
+ *  - Value aspirationWindow() and Value aspirationLimit(): half the width of
+ *    the aspiration window, and the largest value it is used around
+ *  - double timeMargin(int pThreads) and double iterationGrowth(): how long
+ *    before the deadline the search stops, and by how much the time of an
+ *    iteration is expected to grow with the next one
+ *
+ * The traits are only used through static calls, so each game gets its own
+ * search with its evaluation and move generation inlined.
+ */
+template <class Game>
+class Search
+{
+public:
+    typedef typename Game::State State;
+    typedef typename Game::Move Move;
+    typedef typename Game::MoveList MoveList;
+    typedef typename Game::Value Value;
+    typedef common::TranspositionTable<Value> TranspositionTable;
+    typedef common::MoveOrdering<Move, MoveList> MoveOrdering;
+
+    ///the deepest ply searched, quiescence included
+    static const int cMaxPly = MoveOrdering::cMaxPly;
+
+    Search()
+        :   mTotalNodes(0)
+        ,   mSearchId(0)
+        ,   mVerbose(false)
+        ,   mOurPlayer(0)
+        ,   mPreviousPvLength(0)
+        ,   mAbort(false)
+        ,   mPonderPlayer(0)
+        ,   mPonderDone(false)
+    {
+    }
+
+    ~Search()    {    stopPondering();    }
+
+    ///sets the size of the transposition table in megabytes, which is kept for
+    ///the whole game
+    void setHashSize(std::size_t pMegaBytes)    {    mTable.resize(pMegaBytes);    }
+
+    ///sets the number of threads the root moves are searched on
+    void setThreads(int pThreads)    {    mPool.resize(std::max(pThreads, 1));    }
+
+    ///sets whether each search logs its iterations, nodes/s and pondering to
+    ///std::cerr
+    void setVerbose(bool pVerbose)    {    mVerbose = pVerbose;    }
+
+    ///forgets what the searches of the previous game found
+    void newGame()
+    {
+        stopPondering();
+        mTable.clear();
+        mPreviousPvLength = 0;
+    }
+
+    ///returns the number of nodes the last search visited
+    uint64_t getNodes() const    {    return mTotalNodes;    }
+
+    /**
+     * Returns the best move of \p pOurPlayer from \p pState, which must not be
+     * the end of the game, searching until shortly before \p pDue
+     *
+     * Iterative deepening: depth 1, 2, 3, ... are searched, and the best move
+     * of the last iteration that completed is kept. Depth 1 always completes,
+     * so a move is returned even if time is short.
+     *
+     * If the opponent played the reply startPondering() expected, the search
+     * started then goes on until the deadline instead.
+     */
+    Move bestMove(const Deadline &pDue, const State &pState, uint8_t pOurPlayer)
+    {
+        if (mPonderThread.joinable())
+        {
+            if (pOurPlayer == mPonderPlayer && pState.toMessage() == mPonderState.toMessage())
+            {
+                if (mVerbose)
+                    std::cerr << "ponder:hit" << std::endl;
+                const double lMargin = Game::timeMargin(mPool.size());
+                while (!mPonderDone && pDue - Deadline::now() > lMargin)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                stopPondering();
+                return mPonderMove;
+            }
+            // The transposition table keeps what the search found
+            if (mVerbose)
+                std::cerr << "ponder:miss" << std::endl;
+            stopPondering();
+        }
+        return think(pDue, pState, pOurPlayer);
+    }
+
+    /**
+     * Starts searching, on a thread of its own, the position after the reply
+     * the last search expects to our move, which led to \p pState
+     *
+     * The search runs while the opponent thinks, until the next bestMove()
+     * stops it. Does nothing if the last search did not choose the move that
+     * led to \p pState, or has no reply in its principal variation.
+     */
+    void startPondering(const State &pState)
+    {
+        stopPondering();
+        if (pState.isEOG() || mPreviousPvLength < 2 || !(mPreviousPv[0] == pState.getMove()))
+            return;
+
+        State lState = pState;
+        MoveList lMoves;
+        lState.generateMoves(lMoves);
+        int lReply = findMove(mPreviousPv[1], lMoves);
+        if (lReply < 0)
+            return;
+        typename State::UndoInfo lUndo;
+        lState.doMove(lMoves[lReply], lUndo);
+        if (lState.isEOG())
+            return;
+
+        if (mVerbose)
+            std::cerr << "ponder:" << lMoves[lReply].toString() << std::endl;
+        mPonderState = lState;
+        mPonderPlayer = mOurPlayer;
+        mPonderDone = false;
+        mPonderThread = std::thread([this]()
+        {
+            mPonderMove = think(Deadline::now() + cPonderTime, mPonderState, mPonderPlayer);
+            mPonderDone = true;
+        });
+    }
+
+    ///stops the search started by startPondering(), if it is running
+    void stopPondering()
+    {
+        if (!mPonderThread.joinable())
+            return;
+        mAbort = true;
+        mControl.stop();
+        mPonderThread.join();
+        mAbort = false;
+    }
+
+private:
+    ///how long a search started by startPondering() may run
+    static const int cPonderTime = 3600;
+
+    ///bestMove() without pondering
+    Move think(const Deadline &pDue, const State &pState, uint8_t pOurPlayer)
+    {
+        Deadline lStart = Deadline::now();
+        sNodeCount = 0;
+        mTotalNodes = 0;
+        mTable.newSearch();
+        sOrdering.startSearch(++mSearchId);
+        mOurPlayer = pOurPlayer;
+
+        State lState = pState;
+        MoveList lMoves;
+        lState.generateMoves(lMoves);
+        assert(!lMoves.empty());
+        Game::pruneRootMoves(lState, lMoves);
+
+        // Each iteration searches the best move of the previous one first, with its
+        // principal variation, then the other root moves by their previous values
+        Evaluation lBest = { lMoves[0], -cInfinity };
+        mPreviousPvLength = 0;
+        const double lMargin = Game::timeMargin(mPool.size());
+        const Deadline lNoDue = Deadline::now() + 3600;
+        const int lMaxDepth = std::min(Game::maxDepth(lState), cMaxPly - 1);
+        for (int lDepth = 1; lDepth <= lMaxDepth; ++lDepth)
+        {
+            Deadline lIterationStart = Deadline::now();
+            mControl.start(lDepth == 1 ? lNoDue : pDue, lMargin);
+            if (mAbort)
+                mControl.stop();
+
+            // Aspiration window: the value is expected to stay close to the one of the
+            // previous iteration. When it falls outside, the iteration is searched again
+            // with the window opened on that side.
+            Value lWindowAlpha = -cInfinity;
+            Value lWindowBeta = cInfinity;
+            if (lDepth > 1 && std::abs(lBest.mValue) < Game::aspirationLimit())
+            {
+                lWindowAlpha = lBest.mValue - Game::aspirationWindow();
+                lWindowBeta = lBest.mValue + Game::aspirationWindow();
+            }
+
+            Evaluation lEvals[MoveList::cCapacity];
+            int lIterationBest;
+            Move lIterationPv[cMaxPly];
+            int lIterationPvLength = 0;
+            for (;;)
+            {
+                lIterationBest = searchRoot(lState, lMoves, lDepth, lWindowAlpha, lWindowBeta, lEvals, lIterationPv, lIterationPvLength);
+                if (mControl.stopped())
+                    break;
+                if (lIterationBest < 0)
+                {
+                    if (mVerbose)
+                        std::cerr << "depth:" << lDepth << ":fail_low" << std::endl;
+                    lWindowAlpha = -cInfinity;
+                }
+                else if (lWindowBeta != cInfinity && lEvals[lIterationBest].mValue >= lWindowBeta)
+                {
+                    if (mVerbose)
+                        std::cerr << "depth:" << lDepth << ":fail_high" << std::endl;
+                    lWindowBeta = cInfinity;
+                }
+                else
+                    break;
+            }
+            if (mControl.stopped())
+            {
+                if (mVerbose)
+                    std::cerr << "depth:" << lDepth << ":aborted" << std::endl;
+                break;
+            }
+
+            lBest = lEvals[lIterationBest];
+            mPreviousPvLength = lIterationPvLength;
+            std::copy(lIterationPv, lIterationPv + lIterationPvLength, mPreviousPv);
+            double lIterationTime = Deadline::now() - lIterationStart;
+            if (mVerbose)
+                std::cerr << "depth:" << lDepth << ":best:" << lBest.mMove.toString() << ":value:" << lBest.mValue << ":time:" << lIterationTime << std::endl;
+
+            // Next iteration: best move first, the rest by their (bounded) values
+            std::swap(lEvals[0], lEvals[lIterationBest]);
+            std::stable_sort(lEvals + 1, lEvals + lMoves.size());
+            for (int i = 0; i < lMoves.size(); ++i)
+                lMoves[i] = lEvals[i].mMove;
+
+            if (lMoves.size() == 1 || Game::isDecided(lBest.mValue))
+                break; // forced move or decided game, a deeper search does not change the move
+            if (lIterationTime * Game::iterationGrowth() > pDue - Deadline::now() - lMargin)
+                break;
+        }
+
+        mTotalNodes += sNodeCount;
+        sNodeCount = 0;
+        double lElapsed = Deadline::now() - lStart;
+        if (mVerbose)
+            std::cerr << "nodes:" << mTotalNodes << ":nodes/s:" << (long)(lElapsed > 0 ? mTotalNodes / lElapsed : 0) << std::endl;
+
+        return lBest.mMove;
+    }
+
+    ///the kind of bound stored in the transposition table
+    enum EFlag
+    {
+        EXACT,
+        LOWERBOUND,
+        UPPERBOUND
+    };
+
+    struct Evaluation
+    {
+        Move mMove;
+        Value mValue;
+
+        ///sorts the best value first
+        bool operator<(const Evaluation &pRH) const    {    return mValue > pRH.mValue;    }
+    };
+
+    static const Value cInfinity;
+
+    ///the upper end of the null window (\p pAlpha, nullWindow(\p pAlpha)): a search
+    ///with it only tells whether the value is above \p pAlpha
+    static int nullWindow(int pAlpha)       {    return pAlpha + 1;    }
+    static float nullWindow(float pAlpha)   {    return std::nextafter(pAlpha, std::numeric_limits<float>::max());    }
+
+    /**
+     * Searches the root moves \p pMoves to depth \p pDepth within the window
+     * (\p pAlpha, \p pBeta), and returns the index of the best one, or -1 if
+     * none is above \p pAlpha
+     *
+     * The first move is searched alone to get a bound, then the other moves are
+     * shared out among the threads, which take the next unsearched one when they
+     * are done with theirs. They are searched with a null window around the best
+     * value so far, and only those that beat it are searched again to get their
+     * value. The best of those wins, the first move in the list on ties. The
+     * search stops at the first move that fails high.
+     */
+    int searchRoot(State &pState, MoveList &pMoves, int pDepth, Value pAlpha, Value pBeta,
+                   Evaluation *pEvals, Move *pPv, int &pPvLength)
+    {
+        int lBest = -1;
+        std::atomic<int> lNextMove(1);
+        std::atomic<Value> lSharedAlpha(pAlpha);
+        std::atomic<bool> lFailedHigh(false);
+        std::mutex lBestMutex;
+        auto lSearchMove = [&](typename SearchControl::Poll &pPoll, State &pThreadState, int i)
+        {
+            sFollowPv = i == 0 && mPreviousPvLength > 1;
+            Value lAlpha = lSharedAlpha;
+            if (lAlpha == cInfinity)
+            {
+                // A move already reached the largest value, which nothing beats
+                // and which has no null window above it
+                pEvals[i].mMove = pMoves[i];
+                pEvals[i].mValue = -cInfinity;
+                return;
+            }
+            typename State::UndoInfo lUndo;
+            pThreadState.doMove(pMoves[i], lUndo);
+            Value lValue;
+            if (i == 0)
+                lValue = -search(pPoll, pThreadState, pDepth - 1, 1, -1, -pBeta, -lAlpha);
+            else
+            {
+                lValue = -search(pPoll, pThreadState, pDepth - 1, 1, -1, -nullWindow(lAlpha), -lAlpha);
+                if (lValue > lAlpha && lValue < pBeta)
+                    lValue = -search(pPoll, pThreadState, pDepth - 1, 1, -1, -pBeta, -lAlpha);
+            }
+            pThreadState.undoMove(pMoves[i], lUndo);
+            sFollowPv = false;
+            if (mControl.stopped())
+                return;
+
+            pEvals[i].mMove = pMoves[i];
+            pEvals[i].mValue = lValue;
+            if (lValue <= lAlpha && lAlpha != -cInfinity)
+                return; // only a bound, and no better than a move already searched
+            std::lock_guard<std::mutex> lLock(lBestMutex);
+            if (lBest < 0 || lValue > pEvals[lBest].mValue || (lValue == pEvals[lBest].mValue && i < lBest))
+            {
+                lBest = i;
+                updatePv(0, pMoves[i]);
+                pPvLength = sPvLength[0];
+                std::copy(sPv[0], sPv[0] + sPvLength[0], pPv);
+            }
+            if (lValue >= pBeta && pBeta != cInfinity)
+                lFailedHigh = true;
+            for (Value lCurrent = lSharedAlpha; lValue > lCurrent && !lSharedAlpha.compare_exchange_weak(lCurrent, lValue);)
+            {
+            }
+        };
+
+        typename SearchControl::Poll lPoll(mControl);
+        lSearchMove(lPoll, pState, 0);
+        if (pMoves.size() > 1 && !mControl.stopped() && !lFailedHigh)
+        {
+            mPool.run([&](int)
+            {
+                typename SearchControl::Poll lThreadPoll(mControl);
+                State lThreadState = pState;
+                sOrdering.startSearch(mSearchId);
+                for (int i = lNextMove++; i < pMoves.size() && !mControl.stopped() && !lFailedHigh; i = lNextMove++)
+                    lSearchMove(lThreadPoll, lThreadState, i);
+                mTotalNodes += sNodeCount;
+                sNodeCount = 0;
+            });
+        }
+        return lBest;
+    }
+
+    /**
+     * Returns the value of \p pState for the player to move, \p pPly plies from
+     * the root with \p pDepth plies left to search
+     *
+     * \p pColor is 1 when we are to move and -1 otherwise. Moves are played on
+     * \p pState with doMove/undoMove, and it is left as it was found.
+     */
+    Value search(typename SearchControl::Poll &pPoll, State &pState, int pDepth, int pPly, int pColor, Value pAlpha, Value pBeta)
+    {
+        ++sNodeCount;
+        sPvLength[pPly] = pPly;
+        if (pPoll.shouldStop())
+            return 0;
+
+        if (pState.isEOG())
+            return pColor * Game::evaluate(pState, mOurPlayer);
+        Value lKnown;
+        if (Game::probe(pState, mOurPlayer, lKnown))
+            return pColor * lKnown;
+        // At the horizon, positions where the game is not quiet are searched further
+        if ((pDepth <= 0 && Game::isQuiet(pState)) || pPly >= cMaxPly - 1)
+            return pColor * Game::evaluate(pState, mOurPlayer);
+        pDepth = std::max(pDepth, 0);
+
+        // Values are relative to the player to move, who is known from the position
+        Value lAlphaOrig = pAlpha;
+        Value lBetaOrig = pBeta;
+        int lSymmetry;
+        uint64_t lKey = Game::key(pState, lSymmetry);
+        typename TranspositionTable::Entry lEntry;
+        bool lFound = mTable.probe(lKey, lEntry);
+        if (lFound && lEntry.mDepth >= pDepth)
+        {
+            switch (lEntry.mFlag)
+            {
+            case EXACT:
+                return lEntry.mValue;
+            case LOWERBOUND:
+                if (lEntry.mValue > pAlpha)
+                    pAlpha = lEntry.mValue;
+                break;
+            case UPPERBOUND:
+                if (lEntry.mValue < pBeta)
+                    pBeta = lEntry.mValue;
+                break;
+            }
+            if (pAlpha >= pBeta)
+                return lEntry.mValue;
+        }
+
+        // The move of the previous principal variation comes first while following
+        // it, otherwise the best move stored in the table, then the others by
+        // winning moves, captures, killers and history
+        MoveList lMoves;
+        pState.generateMoves(lMoves);
+        int lFirst = -1;
+        if (sFollowPv)
+        {
+            lFirst = pPly < mPreviousPvLength ? findMove(mPreviousPv[pPly], lMoves) : -1;
+            sFollowPv = lFirst >= 0;
+        }
+        if (!sFollowPv && lFound)
+            lFirst = Game::unpackMove(lMoves, lEntry.mBestMove, lSymmetry);
+        uint8_t lPlayer = pState.getNextPlayer();
+        typename MoveOrdering::Picker lPicker(sOrdering, lMoves, pPly, lPlayer, lFirst);
+
+        // Principal variation search: the first move is expected to be the best, so
+        // the others are searched with a null window, and again with the full window
+        // only when they turn out to be better
+        Value lBest = -cInfinity;
+        int lBestMove = 0;
+        int lSearched = 0;
+        typename State::UndoInfo lUndo;
+        for (int i = lPicker.next(); i >= 0; i = lPicker.next())
+        {
+            pState.doMove(lMoves[i], lUndo);
+            Value lValue;
+            if (lSearched == 0)
+                lValue = -search(pPoll, pState, pDepth - 1, pPly + 1, -pColor, -pBeta, -pAlpha);
+            else
+            {
+                lValue = -search(pPoll, pState, pDepth - 1, pPly + 1, -pColor, -nullWindow(pAlpha), -pAlpha);
+                if (lValue > pAlpha && lValue < pBeta)
+                    lValue = -search(pPoll, pState, pDepth - 1, pPly + 1, -pColor, -pBeta, -pAlpha);
+            }
+            pState.undoMove(lMoves[i], lUndo);
+            sFollowPv = false;
+            if (mControl.stopped())
+                return 0;
+
+            if (lSearched++ == 0 || lValue > lBest)
+            {
+                lBest = lValue;
+                lBestMove = i;
+                updatePv(pPly, lMoves[i]);
+            }
+            if (lValue > pAlpha)
+                pAlpha = lValue;
+            if (pAlpha >= pBeta)
+            {
+                sOrdering.cutoff(lMoves[i], pPly, lPlayer, pDepth);
+                break;
+            }
+        }
+
+        EFlag lFlag;
+        if (lBest <= lAlphaOrig)
+            lFlag = UPPERBOUND;
+        else if (lBest >= lBetaOrig)
+            lFlag = LOWERBOUND;
+        else
+            lFlag = EXACT;
+        mTable.store(lKey, lBest, lFlag, pDepth, Game::packMove(lMoves, lBestMove, lSymmetry));
+
+        return lBest;
+    }
+
+    ///makes \p pMove followed by the principal variation of the next ply the
+    ///principal variation of ply \p pPly
+    static void updatePv(int pPly, const Move &pMove)
+    {
+        sPv[pPly][pPly] = pMove;
+        for (int i = pPly + 1; i < sPvLength[pPly + 1]; ++i)
+            sPv[pPly][i] = sPv[pPly + 1][i];
+        sPvLength[pPly] = std::max(sPvLength[pPly + 1], pPly + 1);
+    }
+
+    ///returns the index of \p pMove in \p pMoves, or -1
+    static int findMove(const Move &pMove, const MoveList &pMoves)
+    {
+        for (int i = 0; i < pMoves.size(); ++i)
+            if (pMoves[i] == pMove)
+                return i;
+        return -1;
+    }
+
+    TranspositionTable mTable;
+    ThreadPool mPool;
+    SearchControl mControl;
+    std::atomic<uint64_t> mTotalNodes;
+    unsigned mSearchId;
+    bool mVerbose;
+    uint8_t mOurPlayer;
+    ///the principal variation of the last completed iteration, searched first
+    Move mPreviousPv[cMaxPly];
+    int mPreviousPvLength;
+    ///set while stopPondering() stops the search
+    std::atomic<bool> mAbort;
+
+    // The search started by startPondering(), and its result once it is done
+    std::thread mPonderThread;
+    State mPonderState;
+    uint8_t mPonderPlayer;
+    Move mPonderMove;
+    std::atomic<bool> mPonderDone;
+
+    // Each search thread has its own node count, move ordering tables and principal
+    // variation: sPv[ply] holds the best line found from ply on, and sFollowPv is
+    // set while the search is still on the previous principal variation
+    static thread_local uint64_t sNodeCount;
+    static thread_local MoveOrdering sOrdering;
+    static thread_local bool sFollowPv;
+    static thread_local Move sPv[cMaxPly][cMaxPly];
+    static thread_local int sPvLength[cMaxPly];
+};
+
+template <class Game>
+const typename Search<Game>::Value Search<Game>::cInfinity = std::numeric_limits<typename Search<Game>::Value>::max();
+
+template <class Game>
+thread_local uint64_t Search<Game>::sNodeCount = 0;
+
+template <class Game>
+thread_local typename Search<Game>::MoveOrdering Search<Game>::sOrdering;
+
+template <class Game>
+thread_local bool Search<Game>::sFollowPv = false;
+
+template <class Game>
+thread_local typename Search<Game>::Move Search<Game>::sPv[Search<Game>::cMaxPly][Search<Game>::cMaxPly];
+
+template <class Game>
+thread_local int Search<Game>::sPvLength[Search<Game>::cMaxPly];
+
+/*namespace common*/ }
+
+#endif
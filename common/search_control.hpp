@@ -0,0 +1,74 @@
+#ifndef _COMMON_SEARCH_CONTROL_HPP_
+#define _COMMON_SEARCH_CONTROL_HPP_
+
+#include "deadline.hpp"
+#include <atomic>
+
+namespace common {
+
+/**
+ * Stops a search when its time is up
+ *
+ * All the threads of a search share one SearchControl, and each of them polls
+ * it through its own Poll at every node. Polls only read the clock every few
+ * nodes (see DeadlinePoll). The first thread to find that the time is up raises
+ * the stop flag, and the others see it at their next node without reading the
+ * clock. A search that sees the flag returns at once, and its result is
+ * discarded.
+ */
+class SearchControl
+{
+public:
+    SearchControl()
+        :   mMargin(0)
+        ,   mStop(false)
+    {
+    }
+
+    ///starts a search that must stop \p pMargin seconds before \p pDue
+    void start(const Deadline &pDue, double pMargin)
+    {
+        mDue = pDue;
+        mMargin = pMargin;
+        mStop.store(false, std::memory_order_relaxed);
+    }
+
+    ///stops the search
+    void stop()     {    mStop.store(true, std::memory_order_relaxed);    }
+
+    ///returns true once the search must stop
+    bool stopped() const    {    return mStop.load(std::memory_order_relaxed);    }
+
+    ///polls a SearchControl for one thread
+    class Poll
+    {
+    public:
+        ///starts polling \p pControl, which must have been started
+        explicit Poll(SearchControl &pControl)
+            :   mControl(pControl)
+            ,   mDeadline(pControl.mDue, pControl.mMargin)
+        {
+        }
+
+        ///to be called at every node: returns true once the search must stop
+        bool shouldStop()
+        {
+            if (mDeadline.expired())
+                mControl.stop();
+            return mControl.stopped();
+        }
+
+    private:
+        SearchControl &mControl;
+        DeadlinePoll mDeadline;
+    };
+
+private:
+    Deadline mDue;
+    double mMargin;
+    std::atomic<bool> mStop;
+};
+
+/*namespace common*/ }
+
+#endif
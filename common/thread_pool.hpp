@@ -0,0 +1,114 @@
+#ifndef _COMMON_THREAD_POOL_HPP_
+#define _COMMON_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+/**
+ * A fixed set of threads that run the same job together
+ *
+ * run() hands the job to every worker thread and runs it on the calling thread
+ * too, then waits until all of them are done. With one thread no worker is
+ * started and run() is a plain call.
+ */
+class ThreadPool
+{
+public:
+    ///creates a pool running jobs on \p pThreads threads (the caller included)
+    explicit ThreadPool(int pThreads = 1)
+        :   mGeneration(0)
+        ,   mBusy(0)
+        ,   mQuit(false)
+    {
+        resize(pThreads);
+    }
+
+    ~ThreadPool()
+    {
+        stop();
+    }
+
+    ///changes the number of threads jobs run on
+    void resize(int pThreads)
+    {
+        stop();
+        mQuit = false;
+        for (int i = 1; i < pThreads; ++i)
+            mWorkers.push_back(std::thread(&ThreadPool::work, this, i, mGeneration));
+    }
+
+    ///returns the number of threads jobs run on
+    int size() const    {    return (int)mWorkers.size() + 1;    }
+
+    ///runs \p pJob(i) on every thread i (0 being the calling thread) and waits for all of them
+    void run(const std::function<void(int)> &pJob)
+    {
+        {
+            std::lock_guard<std::mutex> lLock(mMutex);
+            mJob = pJob;
+            mBusy = (int)mWorkers.size();
+            ++mGeneration;
+        }
+        mWake.notify_all();
+
+        pJob(0);
+
+        std::unique_lock<std::mutex> lLock(mMutex);
+        mDone.wait(lLock, [this] { return mBusy == 0; });
+    }
+
+private:
+    ///runs every job handed out after generation \p pGeneration
+    void work(int pIndex, unsigned pGeneration)
+    {
+        unsigned lGeneration = pGeneration;
+        for (;;)
+        {
+            std::function<void(int)> lJob;
+            {
+                std::unique_lock<std::mutex> lLock(mMutex);
+                mWake.wait(lLock, [&] { return mQuit || mGeneration != lGeneration; });
+                if (mQuit)
+                    return;
+                lGeneration = mGeneration;
+                lJob = mJob;
+            }
+
+            lJob(pIndex);
+
+            std::lock_guard<std::mutex> lLock(mMutex);
+            if (--mBusy == 0)
+                mDone.notify_one();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lLock(mMutex);
+            mQuit = true;
+        }
+        mWake.notify_all();
+        for (size_t i = 0; i < mWorkers.size(); ++i)
+            mWorkers[i].join();
+        mWorkers.clear();
+    }
+
+    std::vector<std::thread> mWorkers;
+    std::function<void(int)> mJob;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    unsigned mGeneration;
+    int mBusy;
+    bool mQuit;
+};
+
+/*namespace common*/ }
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef _COMMON_TRANSPOSITION_TABLE_HPP_
+#define _COMMON_TRANSPOSITION_TABLE_HPP_
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace common {
+
+/**
+ * A fixed-size transposition table
+ *
+ * The table is allocated once and kept for the whole game. It is made of
+ * buckets of four entries, one cache line each. A key is stored in the bucket
+ * selected by its low bits. The first three entries of a bucket are depth-preferred:
+ * a new key replaces the least useful of them (empty, from an older search or
+ * shallowest), unless that one is deeper than the new entry and from the
+ * current search, in which case the new key goes to the fourth, always-replace
+ * entry.
+ *
+ * Several threads may probe and store at the same time without locking. Each
+ * entry is two 64-bit words, the data and the key xor-ed with the data, so an
+ * entry torn by two concurrent stores no longer matches its key and is ignored.
+ *
+ * \p Value is the type of the values of the search, int or float. A best move
+ * is stored as the byte the game packs it into (see Search).
+ */
+template <class Value>
+class TranspositionTable
+{
+public:
+    ///a stored search result, packed in 64 bits
+    struct Entry
+    {
+        Value mValue;       ///< the value found by the search
+        int8_t mDepth;      ///< remaining depth of the search, -1 when empty
+        uint8_t mFlag;      ///< kind of bound, opaque to the table
+        uint8_t mBestMove;  ///< the best move, packed by the game
+        uint8_t mAge;       ///< the search that stored the entry
+    };
+
+    static_assert(sizeof(Entry) == sizeof(uint64_t), "an entry must fit in one word");
+
+    static const int cBucketSize = 4;
+    static const std::size_t cDefaultSizeMB = 64;
+
+    ///creates a table that uses at most \p pMegaBytes megabytes
+    explicit TranspositionTable(std::size_t pMegaBytes = cDefaultSizeMB)
+        :   mBuckets(NULL)
+        ,   mMask(0)
+        ,   mAge(0)
+    {
+        resize(pMegaBytes);
+    }
+
+    ///reallocates the table to the largest power of two of buckets that fits
+    ///in \p pMegaBytes megabytes (at least one bucket), and clears it
+    void resize(std::size_t pMegaBytes)
+    {
+        std::size_t lBuckets = 1;
+        while (lBuckets * 2 * sizeof(Bucket) <= pMegaBytes * 1024 * 1024)
+            lBuckets *= 2;
+
+        // vector does not honour the alignment of Bucket before C++17
+        mStorage.assign(lBuckets * sizeof(Bucket) + sizeof(Bucket), 0);
+        std::size_t lAddress = reinterpret_cast<std::size_t>(&mStorage[0]);
+        std::size_t lOffset = (sizeof(Bucket) - lAddress % sizeof(Bucket)) % sizeof(Bucket);
+        mBuckets = reinterpret_cast<Bucket*>(&mStorage[0] + lOffset);
+        for (std::size_t i = 0; i < lBuckets; ++i)
+            new (&mBuckets[i]) Bucket();
+        mMask = lBuckets - 1;
+        clear();
+    }
+
+    ///removes all entries
+    void clear()
+    {
+        Entry lEmpty;
+        std::memset(&lEmpty, 0, sizeof(lEmpty));
+        lEmpty.mDepth = -1;
+        for (std::size_t i = 0; i <= mMask; ++i)
+            for (int j = 0; j < cBucketSize; ++j)
+                write(mBuckets[i].mSlots[j], 0, lEmpty);
+        mAge = 0;
+    }
+
+    ///starts a new search: entries stored by previous ones are still found by
+    ///probe(), but are the first to be replaced
+    void newSearch()    {    ++mAge;    }
+
+    ///copies the entry stored for \p pKey to \p pEntry, returns false if there is none
+    bool probe(uint64_t pKey, Entry &pEntry) const
+    {
+        const Bucket &lBucket = mBuckets[pKey & mMask];
+        for (int i = 0; i < cBucketSize; ++i)
+        {
+            uint64_t lData = lBucket.mSlots[i].mData.load(std::memory_order_relaxed);
+            uint64_t lKey = lBucket.mSlots[i].mKey.load(std::memory_order_relaxed) ^ lData;
+            if (lKey == pKey)
+            {
+                pEntry = unpack(lData);
+                return pEntry.mDepth >= 0;
+            }
+        }
+        return false;
+    }
+
+    ///stores a search result for \p pKey, overwriting any previous entry for it
+    void store(uint64_t pKey, Value pValue, uint8_t pFlag, int pDepth, int pBestMove)
+    {
+        Bucket &lBucket = mBuckets[pKey & mMask];
+        Slot *lReplace = NULL;
+        Entry lEntries[cBucketSize];
+        for (int i = 0; i < cBucketSize; ++i)
+        {
+            uint64_t lData = lBucket.mSlots[i].mData.load(std::memory_order_relaxed);
+            lEntries[i] = unpack(lData);
+            if ((lBucket.mSlots[i].mKey.load(std::memory_order_relaxed) ^ lData) == pKey)
+            {
+                lReplace = &lBucket.mSlots[i];
+                break;
+            }
+        }
+
+        if (!lReplace)
+        {
+            int lWeakest = 0;
+            for (int i = 1; i < cBucketSize - 1; ++i)
+                if (worth(lEntries[i]) < worth(lEntries[lWeakest]))
+                    lWeakest = i;
+            if (lEntries[lWeakest].mAge == mAge && lEntries[lWeakest].mDepth > pDepth)
+                lWeakest = cBucketSize - 1;
+            lReplace = &lBucket.mSlots[lWeakest];
+        }
+
+        Entry lEntry;
+        lEntry.mValue = pValue;
+        lEntry.mDepth = (int8_t)pDepth;
+        lEntry.mFlag = pFlag;
+        lEntry.mBestMove = (uint8_t)pBestMove;
+        lEntry.mAge = mAge;
+        write(*lReplace, pKey, lEntry);
+    }
+
+    ///returns the number of entries the table can hold
+    std::size_t size() const    {    return (mMask + 1) * cBucketSize;    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> mKey;     ///< the key xor-ed with mData
+        std::atomic<uint64_t> mData;    ///< the packed Entry
+    };
+
+    struct Bucket
+    {
+        Slot mSlots[cBucketSize];
+    };
+
+    static uint64_t pack(const Entry &pEntry)
+    {
+        uint64_t lData;
+        std::memcpy(&lData, &pEntry, sizeof(lData));
+        return lData;
+    }
+
+    static Entry unpack(uint64_t pData)
+    {
+        Entry lEntry;
+        std::memcpy(&lEntry, &pData, sizeof(lEntry));
+        return lEntry;
+    }
+
+    static void write(Slot &pSlot, uint64_t pKey, const Entry &pEntry)
+    {
+        uint64_t lData = pack(pEntry);
+        pSlot.mKey.store(pKey ^ lData, std::memory_order_relaxed);
+        pSlot.mData.store(lData, std::memory_order_relaxed);
+    }
+
+    ///how much an entry is worth keeping: entries of older searches are worth
+    ///less than any entry of the current one, empty entries least of all
+    int worth(const Entry &pEntry) const
+    {
+        return pEntry.mDepth + (pEntry.mAge == mAge ? 256 : 0);
+    }
+
+    std::vector<char> mStorage;
+    Bucket *mBuckets;
+    std::size_t mMask;
+    uint8_t mAge;
+};
+
+/*namespace common*/ }
+
+#endif